@@ -0,0 +1,508 @@
+// Micro-benchmarks for the per-second path of the timer list: the tick with its row
+// re-render and visibility check, the focused timer's time text, the menu list lookups,
+// the duration formatting, against the snprintf it replaced, and the icon cache.
+//
+//   build/basalt/bench                     # 10, 32, 64, 100 and 1000 timers, half running
+//   build/basalt/bench -n 64 -r 1.0 -m 500
+//
+// The tick, its row updates and the timer window's time are timer_view.c, as on the
+// watch; only the MenuLayer is stood in for. Every call the tick makes is counted to
+// give ops/tick, the number of times an operation runs per second tick with the menu
+// on screen. Each result is one JSON object per line:
+//
+//   {"platform":"basalt","timers":64,"requested":100,"running":0.50,"op":"tick",
+//    "ns_per_op":812.4,"ops_per_tick":1.00}
+//
+// requested differs from timers when the count is over MAX_TIMERS; the pool is capped.
+
+#include <pebble.h>
+#include <inttypes.h>
+#include "timer_core.h"
+#include "timer_view.h"
+#include "icon_cache.h"
+
+#if defined(PBL_PLATFORM_APLITE)
+#define PLATFORM_NAME "aplite"
+#elif defined(PBL_PLATFORM_BASALT)
+#define PLATFORM_NAME "basalt"
+#elif defined(PBL_PLATFORM_CHALK)
+#define PLATFORM_NAME "chalk"
+#elif defined(PBL_PLATFORM_DIORITE)
+#define PLATFORM_NAME "diorite"
+#else
+#define PLATFORM_NAME "unknown"
+#endif
+
+#define BENCH_EPOCH         1767571200LL    // Monday 2026-01-05 00:00 UTC
+#define BENCH_MENU_HEIGHT   152             // Screen less the status bar
+#define BENCH_HOT_ICONS     4               // Icons the hit benchmark cycles through
+#define BENCH_CLOCK_CYCLE   30              // Seconds the tick clock repeats over
+
+// Menu sections, as in timer.c
+#define SECTION_NEW_TIMER       0
+#define SECTION_TIMERS          1
+#define SECTION_NEW_STOPWATCH   2
+#define SECTION_STOPWATCHES     3
+#define NUM_MENU_SECTIONS       4
+
+static int s_min_ms = 200;
+
+// ------------------------- Call Counts ------------------------
+
+typedef struct
+{
+    uint64_t update_time;
+    uint64_t row_render;
+    uint64_t timer_index;
+    uint64_t timer_menu_index;
+    uint64_t num_rows;
+    uint64_t icon_get;
+} BenchCalls;
+
+static BenchCalls s_calls;
+
+static int bench_timer_index(int section, int row)
+{
+    s_calls.timer_index++;
+    return timer_list_timer(section == SECTION_STOPWATCHES ? TIMER_LIST_STOPWATCHES : TIMER_LIST_TIMERS, row);
+}
+
+static int bench_timer_menu_index(int timer, int *section)
+{
+    s_calls.timer_menu_index++;
+    *section = timer_is_counting_up(timer) ? SECTION_STOPWATCHES : SECTION_TIMERS;
+    return timer_list_row(timer);
+}
+
+static int bench_num_rows(int section)
+{
+    s_calls.num_rows++;
+
+    switch (section)
+    {
+        case SECTION_TIMERS:
+            return timer_list_count(TIMER_LIST_TIMERS);
+
+        case SECTION_STOPWATCHES:
+            return timer_list_count(TIMER_LIST_STOPWATCHES);
+
+        default:
+            return 1;
+    }
+}
+
+static int bench_cell_height(int section)
+{
+    if (section == SECTION_NEW_TIMER || section == SECTION_NEW_STOPWATCH)
+    {
+        return timer_pool_can_add() ? 30 : 0;
+    }
+
+    return 30;
+}
+
+// ------------------------- Menu Stand-in ----------------------
+//
+// menu_row_visible and what MenuLayer does when marked dirty, without the layers.
+
+static int s_focused = 0;
+static uint32_t s_tick = 0;
+static volatile uint32_t s_sink;    // Keeps results from being optimised away
+
+static void bench_update_time(void)
+{
+    static TimerTimeText text;
+
+    s_calls.update_time++;
+    timer_time_text(s_focused, &text);
+    s_sink += text.time[0] + (text.show_hours ? text.hours[0] : 0) + (text.show_days ? text.days[0] : 0);
+}
+
+static bool bench_row_visible(int index)
+{
+    int section;
+    int row = bench_timer_menu_index(index, &section);
+    int y = 0;
+
+    for (int s = 0; s < section; s++)
+    {
+        for (int r = 0; r < bench_num_rows(s); r++)
+        {
+            y += bench_cell_height(s);
+        }
+    }
+
+    y += row * bench_cell_height(section);
+
+    return y + bench_cell_height(section) > 0 && y < BENCH_MENU_HEIGHT;
+}
+
+// What MenuLayer does when marked dirty: draw the rows that fit on screen
+static void bench_menu_redraw(void)
+{
+    int y = 0;
+
+    for (int section = 0; section < NUM_MENU_SECTIONS && y < BENCH_MENU_HEIGHT; section++)
+    {
+        for (int r = 0; r < bench_num_rows(section) && y < BENCH_MENU_HEIGHT; r++)
+        {
+            y += bench_cell_height(section);
+
+            if (section != SECTION_TIMERS && section != SECTION_STOPWATCHES)
+            {
+                continue;
+            }
+
+            int index = bench_timer_index(section, r);
+            s_sink += timer_row_get(index)->status;
+
+            s_calls.icon_get++;
+            s_sink += (uintptr_t)timer_row_icon(index);
+        }
+    }
+}
+
+static void bench_tick(uint32_t tick)
+{
+    // cycle the clock so the shortest countdown never runs out mid-benchmark
+    time_t now = BENCH_EPOCH + tick % BENCH_CLOCK_CYCLE;
+    struct tm tick_time;
+
+    host_set_now_ms(now * 1000);
+    gmtime_r(&now, &tick_time);
+    timer_view_tick(&tick_time, SECOND_UNIT);
+}
+
+// ------------------------- Setup ------------------------------
+
+static void bench_setup(int count, double running)
+{
+    host_persist_reset();
+    host_app_timer_reset();
+    host_set_now_ms(BENCH_EPOCH * 1000);
+    host_heap_free = 1024 * 1024;
+
+    if (count > MAX_TIMERS)
+    {
+        count = MAX_TIMERS;
+    }
+
+    timer_view_init((TimerViewHandlers){
+        .tick = bench_update_time,
+        .row_visible = bench_row_visible,
+        .rows_changed = bench_menu_redraw,
+    });
+    timer_core_init((TimerCoreHandlers){ .pool_resized = timer_rows_resize });
+    timer_core_load();
+
+    while (num_timers > count)
+    {
+        timer_remove(num_timers - 1);
+    }
+
+    // a mix of everything the rows can show: seconds, minutes, hours and days
+    static const uint32_t totals[] = { 45, 9 * 60, 2 * 60 * 60, 3 * SECONDS_PER_DAY, 40 * SECONDS_PER_DAY };
+
+    for (int i = 0; i < count; i++)
+    {
+        int timer = i < num_timers ? i : timer_add(i % 4 == 3);
+
+        if (!timer_is_counting_up(timer))
+        {
+            timer_set_total_sec(timer, totals[i % ARRAY_LENGTH(totals)] + i);
+        }
+
+        timer_set_icon_idx(timer, i % TIMER_ICON_ITEMS);
+    }
+
+    int to_start = running * num_timers + 0.5;
+
+    for (int i = 0; i < num_timers; i++)
+    {
+        // spread the running ones over the whole list
+        if ((i + 1) * to_start / num_timers > i * to_start / num_timers)
+        {
+            timer_start(i);
+        }
+    }
+
+    timer_rows_invalidate_all();
+
+    s_focused = 0;
+    s_tick = 0;
+    timer_view_set_focus(s_focused);
+    timer_icon_cache_init();
+}
+
+static void bench_teardown(void)
+{
+    timer_view_deinit();
+    timer_icon_cache_destroy();
+    timer_core_deinit();
+    host_app_timer_reset();
+}
+
+// ------------------------- Timing -----------------------------
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef void (*BenchLoop)(uint32_t iterations);
+
+// Run the loop with more iterations until it takes s_min_ms; ns per iteration
+static double bench_time(BenchLoop loop)
+{
+    uint32_t iterations = 64;
+
+    loop(iterations);   // warm up
+
+    for (;;)
+    {
+        double start = now_ns();
+        loop(iterations);
+        double elapsed = now_ns() - start;
+
+        if (elapsed >= s_min_ms * 1e6 || iterations >= (1u << 30))
+        {
+            return elapsed / iterations;
+        }
+
+        iterations *= 2;
+    }
+}
+
+static void loop_tick(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        bench_tick(s_tick++);
+    }
+}
+
+static void loop_update_time(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        bench_update_time();
+    }
+}
+
+static void loop_timer_index(uint32_t iterations)
+{
+    int timer_rows = timer_list_count(TIMER_LIST_TIMERS);
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        int row = i % num_timers;
+
+        s_sink += row < timer_rows ? bench_timer_index(SECTION_TIMERS, row) :
+                  bench_timer_index(SECTION_STOPWATCHES, row - timer_rows);
+    }
+}
+
+static void loop_timer_menu_index(uint32_t iterations)
+{
+    int section;
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        s_sink += bench_timer_menu_index(i % num_timers, &section) + section;
+    }
+}
+
+static void loop_num_rows(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        s_sink += bench_num_rows(i % NUM_MENU_SECTIONS);
+    }
+}
+
+static void loop_format_row(uint32_t iterations)
+{
+    char title[30];
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        timer_format_duration(title, sizeof(title), timer_display_sec(i % num_timers), DURATION_ROW);
+        s_sink += title[0];
+    }
+}
+
+// The row formatting as it was before duration.c, to compare against
+static void bench_format_row_snprintf(char *buf, size_t size, uint32_t sec)
+{
+    int days = sec / 60 / 60 / 24;
+    int hours = sec / 60 / 60 - days * 24;
+    int minutes = sec / 60 - days * 24 * 60 - hours * 60;
+    int seconds = sec - days * 24 * 60 * 60 - hours * 60 * 60 - minutes * 60;
+
+    if (days > 99)
+    {
+        snprintf(buf, size, "%dd%02d", days, hours);
+    }
+    else if (days > 0)
+    {
+        snprintf(buf, size, "%dd%02d:%02d", days, hours, minutes);
+    }
+    else if (hours > 0)
+    {
+        snprintf(buf, size, "%2d:%02d:%02d", hours, minutes, seconds);
+    }
+    else
+    {
+        snprintf(buf, size, "%2d:%02d", minutes, seconds);
+    }
+}
+
+static void loop_format_row_snprintf(uint32_t iterations)
+{
+    char title[30];
+
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        bench_format_row_snprintf(title, sizeof(title), timer_display_sec(i % num_timers));
+        s_sink += title[0];
+    }
+}
+
+static void loop_duration(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        s_sink += timer_duration(timer_display_sec(i % num_timers)).seconds;
+    }
+}
+
+static void loop_icon_hit(uint32_t iterations)
+{
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        s_sink += (uintptr_t)timer_icon_cache_get(i % BENCH_HOT_ICONS);
+    }
+}
+
+static void loop_icon_miss(uint32_t iterations)
+{
+    // cycling through every icon in order defeats an LRU smaller than the set
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        s_sink += (uintptr_t)timer_icon_cache_get(i % TIMER_ICON_ITEMS);
+    }
+}
+
+// ------------------------- Report -----------------------------
+
+static void bench_print(int requested, double running, const char *op, double ns, double per_tick,
+                        const char *extra)
+{
+    printf("{\"platform\":\"%s\",\"timers\":%d,\"requested\":%d,\"running\":%.2f,\"op\":\"%s\","
+           "\"ns_per_op\":%.1f,\"ops_per_tick\":%.2f%s}\n",
+           PLATFORM_NAME, num_timers, requested, running, op, ns, per_tick, extra);
+}
+
+static void bench_run(int requested, double running)
+{
+    bench_setup(requested, running);
+
+    // ops/tick comes from the calls one tick makes, counted over a minute of ticks
+    memset(&s_calls, 0, sizeof(s_calls));
+    uint32_t renders_before = timer_view_stats().renders;
+    IconCacheStats icons_before = timer_icon_cache_stats();
+    uint32_t ticks = 60;
+    loop_tick(ticks);
+    BenchCalls calls = s_calls;
+    calls.row_render = timer_view_stats().renders - renders_before;
+    IconCacheStats icons = timer_icon_cache_stats();
+    double icon_hits = icons.hits - icons_before.hits;
+    double icon_lookups = icon_hits + icons.misses - icons_before.misses;
+
+    double ns = bench_time(loop_tick);
+    bench_print(requested, running, "tick", ns, 1.0, "");
+
+    ns = bench_time(loop_update_time);
+    bench_print(requested, running, "update_time", ns, (double)calls.update_time / ticks, "");
+
+    ns = bench_time(loop_format_row);
+    bench_print(requested, running, "format_row", ns, (double)calls.row_render / ticks, "");
+
+    ns = bench_time(loop_format_row_snprintf);
+    bench_print(requested, running, "format_row_snprintf", ns, (double)calls.row_render / ticks, "");
+
+    ns = bench_time(loop_duration);
+    bench_print(requested, running, "duration", ns, (double)calls.update_time / ticks, "");
+
+    ns = bench_time(loop_timer_index);
+    bench_print(requested, running, "timer_index", ns, (double)calls.timer_index / ticks, "");
+
+    ns = bench_time(loop_timer_menu_index);
+    bench_print(requested, running, "timer_menu_index", ns, (double)calls.timer_menu_index / ticks, "");
+
+    ns = bench_time(loop_num_rows);
+    bench_print(requested, running, "num_rows", ns, (double)calls.num_rows / ticks, "");
+
+    char extra[64];
+    snprintf(extra, sizeof(extra), ",\"tick_hit_rate\":%.2f", icon_lookups ? icon_hits / icon_lookups : 1.0);
+
+    ns = bench_time(loop_icon_hit);
+    bench_print(requested, running, "icon_hit", ns, (double)calls.icon_get / ticks, extra);
+
+    IconCacheStats before = timer_icon_cache_stats();
+    ns = bench_time(loop_icon_miss);
+    IconCacheStats after = timer_icon_cache_stats();
+    double lookups = after.hits - before.hits + after.misses - before.misses;
+    snprintf(extra, sizeof(extra), ",\"hit_rate\":%.2f,\"page_loads\":%.2f",
+             (after.hits - before.hits) / lookups, (after.loads - before.loads) / lookups);
+    bench_print(requested, running, "icon_miss", ns, 0.0, extra);
+
+    bench_teardown();
+}
+
+int main(int argc, char **argv)
+{
+    static const int default_counts[] = { 10, 32, 64, 100, 1000 };
+    int counts[16];
+    int num_counts = 0;
+    double running = 0.5;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            for (char *n = strtok(argv[++i], ","); n && num_counts < (int)ARRAY_LENGTH(counts); n = strtok(NULL, ","))
+            {
+                counts[num_counts++] = atoi(n);
+            }
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            running = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc)
+        {
+            s_min_ms = atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n count,...] [-r running fraction] [-m min ms per op]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (num_counts == 0)
+    {
+        memcpy(counts, default_counts, sizeof(default_counts));
+        num_counts = ARRAY_LENGTH(default_counts);
+    }
+
+    for (int i = 0; i < num_counts; i++)
+    {
+        bench_run(counts[i] > 0 ? counts[i] : 1, running < 0 ? 0 : running > 1 ? 1 : running);
+    }
+
+    return 0;
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+// Stand-in for the parts of the Pebble SDK the timer core uses, so it builds and runs
+// on a workstation. Storage is kept in memory, the clock is virtual and only moves
+// when the host program advances it, and AppTimers fire from host_app_timer_run().
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+#define SECONDS_PER_DAY 86400
+
+// ------------------------- Logging ----------------------------
+
+typedef enum
+{
+    APP_LOG_LEVEL_ERROR = 1,
+    APP_LOG_LEVEL_WARNING = 50,
+    APP_LOG_LEVEL_INFO = 100,
+    APP_LOG_LEVEL_DEBUG = 200,
+    APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+extern int host_log_level;  // Messages above this level are dropped
+
+void host_log(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+#define APP_LOG(level, fmt, ...) host_log(level, fmt, ##__VA_ARGS__)
+
+// ------------------------- Time -------------------------------
+
+typedef enum
+{
+    SECOND_UNIT = 1 << 0,
+    MINUTE_UNIT = 1 << 1,
+    HOUR_UNIT = 1 << 2,
+    DAY_UNIT = 1 << 3,
+    MONTH_UNIT = 1 << 4,
+    YEAR_UNIT = 1 << 5,
+} TimeUnits;
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+time_t host_time(time_t *tloc);
+#define time(tloc) host_time(tloc)
+
+int64_t host_now_ms(void);
+void host_set_now_ms(int64_t now);
+
+// ------------------------- Tick Timer Service -----------------
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+// Time of the next tick after the last one delivered; false if not subscribed
+bool host_tick_next(int64_t *due_ms);
+// Deliver the tick due at the current virtual time, if any
+bool host_tick_run(void);
+
+// ------------------------- AppTimer ---------------------------
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *data);
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer);
+
+// Due time of the earliest pending AppTimer; false if none is pending
+bool host_app_timer_next(int64_t *due_ms);
+// Fire every AppTimer due at the current virtual time; the number fired
+int host_app_timer_run(void);
+void host_app_timer_reset(void);
+
+// ------------------------- Persistent Storage -----------------
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+typedef int32_t status_t;
+#define S_SUCCESS 0
+#define E_DOES_NOT_EXIST -4
+#define E_OUT_OF_RESOURCES -7
+#define E_RANGE -8
+
+bool persist_exists(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+status_t persist_write_int(const uint32_t key, const int32_t value);
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size);
+int persist_write_data(const uint32_t key, const void *data, const size_t size);
+status_t persist_delete(const uint32_t key);
+
+void host_persist_reset(void);
+
+// ------------------------- Vibes ------------------------------
+
+typedef struct
+{
+    const uint32_t *durations;
+    uint32_t num_segments;
+} VibePattern;
+
+void vibes_short_pulse(void);
+void vibes_long_pulse(void);
+void vibes_double_pulse(void);
+void vibes_enqueue_custom_pattern(VibePattern pattern);
+
+// ------------------------- Wakeup -----------------------------
+
+typedef int32_t WakeupId;
+
+// Like the firmware, a wakeup within 60 s of another is refused with E_RANGE
+WakeupId wakeup_schedule(time_t timestamp, int32_t cookie, bool notify_if_missed);
+void wakeup_cancel(WakeupId wakeup_id);
+void wakeup_cancel_all(void);
+bool wakeup_query(WakeupId wakeup_id, time_t *timestamp);
+
+// Time of the earliest scheduled wakeup; false if none is scheduled
+bool host_wakeup_next(time_t *timestamp);
+
+// Take the earliest wakeup off the schedule as the firmware does when it fires it;
+// returns its id, or -1 if none is scheduled
+WakeupId host_wakeup_fire(int32_t *cookie);
+
+// ------------------------- App Message ------------------------
+
+typedef enum
+{
+    APP_MSG_OK = 0,
+    APP_MSG_SEND_TIMEOUT = 2,
+    APP_MSG_SEND_REJECTED = 4,
+    APP_MSG_NOT_CONNECTED = 8,
+    APP_MSG_APP_NOT_RUNNING = 16,
+    APP_MSG_INVALID_ARGS = 32,
+    APP_MSG_BUSY = 64,
+    APP_MSG_BUFFER_OVERFLOW = 128,
+    APP_MSG_ALREADY_RELEASED = 512,
+    APP_MSG_CALLBACK_ALREADY_REGISTERED = 1024,
+    APP_MSG_CALLBACK_NOT_REGISTERED = 2048,
+    APP_MSG_OUT_OF_MEMORY = 4096,
+    APP_MSG_CLOSED = 8192,
+    APP_MSG_INTERNAL_ERROR = 16384,
+    APP_MSG_INVALID_STATE = 32768,
+} AppMessageResult;
+
+typedef enum
+{
+    DICT_OK = 0,
+    DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+    DICT_INVALID_ARGS = 1 << 2,
+} DictionaryResult;
+
+// Only counts what is written, against the outbox size given to app_message_open
+typedef struct DictionaryIterator DictionaryIterator;
+
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason, void *context);
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...);
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value);
+DictionaryResult dict_write_uint16(DictionaryIterator *iter, const uint32_t key, const uint16_t value);
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value);
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *const cstring);
+
+// The phone takes every message, HOST_APP_MESSAGE_ACK_MS after it was sent
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+void app_message_deregister_callbacks(void);
+
+// ------------------------- Graphics ---------------------------
+
+typedef struct
+{
+    int16_t x;
+    int16_t y;
+} GPoint;
+
+typedef struct
+{
+    int16_t w;
+    int16_t h;
+} GSize;
+
+typedef struct
+{
+    GPoint origin;
+    GSize size;
+} GRect;
+
+#define GSize(w, h) ((GSize){ (w), (h) })
+#define GRect(x, y, w, h) ((GRect){ { (x), (y) }, { (w), (h) } })
+
+typedef union
+{
+    uint8_t argb;
+} GColor8;
+
+typedef GColor8 GColor;
+
+typedef enum
+{
+    GBitmapFormat1Bit = 0,
+    GBitmapFormat8Bit,
+    GBitmapFormat1BitPalette,
+    GBitmapFormat2BitPalette,
+    GBitmapFormat4BitPalette,
+} GBitmapFormat;
+
+typedef struct GBitmap GBitmap;
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette,
+                                           bool free_on_destroy);
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect);
+void gbitmap_destroy(GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+
+// ------------------------- Resources --------------------------
+
+// The only resource is the icon atlas, read from the file tools/icon_atlas.py wrote
+// for this platform; see the Makefile
+#define RESOURCE_ID_ICON_ATLAS 1
+
+typedef const void *ResHandle;
+
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle h);
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t *buffer, size_t num_bytes);
+
+// ------------------------- Heap -------------------------------
+
+extern size_t host_heap_free;   // What heap_bytes_free() reports
+
+size_t heap_bytes_free(void);
+size_t heap_bytes_used(void);
+
+// ------------------------- Counters ---------------------------
+
+typedef struct
+{
+    uint32_t persist_writes;
+    uint32_t persist_bytes;
+    uint32_t vibes;
+    uint32_t wakeups;
+    uint32_t app_timers_fired;
+    uint32_t ticks;
+    uint32_t bitmaps_loaded;
+    uint32_t resource_bytes;
+    uint32_t messages;
+    uint32_t message_bytes;
+} HostCounters;
+
+extern HostCounters host_counters;
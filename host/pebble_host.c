@@ -0,0 +1,832 @@
+#include <pebble.h>
+#include <stdarg.h>
+#include <sys/time.h>
+
+int host_log_level = APP_LOG_LEVEL_WARNING;
+size_t host_heap_free = 24 * 1024;
+HostCounters host_counters;
+
+// ------------------------- Logging ----------------------------
+
+void host_log(int level, const char *fmt, ...)
+{
+    if (level > host_log_level)
+    {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+// ------------------------- Time -------------------------------
+
+static int64_t s_now_ms = -1;
+
+int64_t host_now_ms(void)
+{
+    if (s_now_ms < 0)
+    {
+        // start at the wall clock time, then only move when told to
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        s_now_ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    }
+
+    return s_now_ms;
+}
+
+void host_set_now_ms(int64_t now)
+{
+    s_now_ms = now;
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms)
+{
+    int64_t now = host_now_ms();
+    uint16_t ms = now % 1000;
+
+    if (tloc)
+    {
+        *tloc = now / 1000;
+    }
+    if (out_ms)
+    {
+        *out_ms = ms;
+    }
+
+    return ms;
+}
+
+time_t host_time(time_t *tloc)
+{
+    time_t t = host_now_ms() / 1000;
+
+    if (tloc)
+    {
+        *tloc = t;
+    }
+
+    return t;
+}
+
+// ------------------------- Tick Timer Service -----------------
+
+static TimeUnits s_tick_units;
+static TickHandler s_tick_handler;
+static int64_t s_tick_last = -1;    // Time of the last tick delivered
+
+static int64_t tick_unit_ms(TimeUnits units)
+{
+    if (units & SECOND_UNIT)
+    {
+        return 1000;
+    }
+    if (units & MINUTE_UNIT)
+    {
+        return 60 * 1000;
+    }
+    if (units & HOUR_UNIT)
+    {
+        return 60 * 60 * 1000;
+    }
+
+    return 24 * 60 * 60 * 1000;
+}
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler)
+{
+    s_tick_units = tick_units;
+    s_tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void)
+{
+    s_tick_units = 0;
+    s_tick_handler = NULL;
+}
+
+bool host_tick_next(int64_t *due_ms)
+{
+    if (!s_tick_handler)
+    {
+        return false;
+    }
+
+    int64_t unit = tick_unit_ms(s_tick_units);
+    int64_t next = (host_now_ms() + unit - 1) / unit * unit;
+
+    if (next <= s_tick_last)
+    {
+        next = (s_tick_last / unit + 1) * unit;
+    }
+
+    *due_ms = next;
+    return true;
+}
+
+bool host_tick_run(void)
+{
+    int64_t due;
+
+    if (!host_tick_next(&due) || due > host_now_ms())
+    {
+        return false;
+    }
+
+    time_t t = due / 1000;
+    struct tm tick_time;
+    gmtime_r(&t, &tick_time);
+
+    TimeUnits changed = SECOND_UNIT;
+    if (tick_time.tm_sec == 0)
+    {
+        changed |= MINUTE_UNIT;
+    }
+    if (tick_time.tm_sec == 0 && tick_time.tm_min == 0)
+    {
+        changed |= HOUR_UNIT;
+    }
+
+    s_tick_last = due;
+    host_counters.ticks++;
+    s_tick_handler(&tick_time, changed);
+    return true;
+}
+
+// ------------------------- AppTimer ---------------------------
+
+#define HOST_MAX_APP_TIMERS 16
+
+struct AppTimer
+{
+    int64_t due_ms;
+    AppTimerCallback callback;
+    void *data;
+    bool active;
+};
+
+static AppTimer s_app_timers[HOST_MAX_APP_TIMERS];
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *data)
+{
+    for (int i = 0; i < HOST_MAX_APP_TIMERS; i++)
+    {
+        if (!s_app_timers[i].active)
+        {
+            s_app_timers[i] = (AppTimer){ host_now_ms() + timeout_ms, callback, data, true };
+            return &s_app_timers[i];
+        }
+    }
+
+    APP_LOG(APP_LOG_LEVEL_ERROR, "app_timer_register out of timers");
+    return NULL;
+}
+
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms)
+{
+    if (!timer || !timer->active)
+    {
+        return false;
+    }
+
+    timer->due_ms = host_now_ms() + new_timeout_ms;
+    return true;
+}
+
+void app_timer_cancel(AppTimer *timer)
+{
+    if (timer)
+    {
+        timer->active = false;
+    }
+}
+
+bool host_app_timer_next(int64_t *due_ms)
+{
+    bool found = false;
+
+    for (int i = 0; i < HOST_MAX_APP_TIMERS; i++)
+    {
+        if (s_app_timers[i].active && (!found || s_app_timers[i].due_ms < *due_ms))
+        {
+            *due_ms = s_app_timers[i].due_ms;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+int host_app_timer_run(void)
+{
+    int fired = 0;
+    int64_t due = 0;
+
+    while (host_app_timer_next(&due) && due <= host_now_ms())
+    {
+        for (int i = 0; i < HOST_MAX_APP_TIMERS; i++)
+        {
+            AppTimer *timer = &s_app_timers[i];
+
+            if (timer->active && timer->due_ms == due)
+            {
+                // the callback may register a new timer in the same slot
+                timer->active = false;
+                timer->callback(timer->data);
+                host_counters.app_timers_fired++;
+                fired++;
+                break;
+            }
+        }
+    }
+
+    return fired;
+}
+
+void host_app_timer_reset(void)
+{
+    memset(s_app_timers, 0, sizeof(s_app_timers));
+}
+
+// ------------------------- Persistent Storage -----------------
+
+#define HOST_MAX_PERSIST_KEYS 256
+
+typedef struct
+{
+    uint32_t key;
+    uint16_t size;
+    bool used;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} HostPersistEntry;
+
+static HostPersistEntry s_persist[HOST_MAX_PERSIST_KEYS];
+
+static HostPersistEntry *persist_find(uint32_t key, bool create)
+{
+    HostPersistEntry *free_entry = NULL;
+
+    for (int i = 0; i < HOST_MAX_PERSIST_KEYS; i++)
+    {
+        if (s_persist[i].used && s_persist[i].key == key)
+        {
+            return &s_persist[i];
+        }
+
+        if (!s_persist[i].used && !free_entry)
+        {
+            free_entry = &s_persist[i];
+        }
+    }
+
+    if (create && free_entry)
+    {
+        free_entry->used = true;
+        free_entry->key = key;
+        free_entry->size = 0;
+        return free_entry;
+    }
+
+    return NULL;
+}
+
+bool persist_exists(const uint32_t key)
+{
+    return persist_find(key, false) != NULL;
+}
+
+int32_t persist_read_int(const uint32_t key)
+{
+    HostPersistEntry *entry = persist_find(key, false);
+    int32_t value = 0;
+
+    if (entry && entry->size == sizeof(value))
+    {
+        memcpy(&value, entry->data, sizeof(value));
+    }
+
+    return value;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value)
+{
+    return persist_write_data(key, &value, sizeof(value)) < 0 ? -1 : S_SUCCESS;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size)
+{
+    HostPersistEntry *entry = persist_find(key, false);
+
+    if (!entry)
+    {
+        return E_DOES_NOT_EXIST;
+    }
+
+    size_t size = entry->size < buffer_size ? entry->size : buffer_size;
+    memcpy(buffer, entry->data, size);
+    return size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size)
+{
+    HostPersistEntry *entry = persist_find(key, true);
+
+    if (!entry)
+    {
+        return -1;
+    }
+
+    entry->size = size < PERSIST_DATA_MAX_LENGTH ? size : PERSIST_DATA_MAX_LENGTH;
+    memcpy(entry->data, data, entry->size);
+    host_counters.persist_writes++;
+    host_counters.persist_bytes += entry->size;
+    return entry->size;
+}
+
+status_t persist_delete(const uint32_t key)
+{
+    HostPersistEntry *entry = persist_find(key, false);
+
+    if (!entry)
+    {
+        return E_DOES_NOT_EXIST;
+    }
+
+    entry->used = false;
+    return S_SUCCESS;
+}
+
+void host_persist_reset(void)
+{
+    memset(s_persist, 0, sizeof(s_persist));
+}
+
+// ------------------------- Vibes ------------------------------
+
+void vibes_short_pulse(void)
+{
+    host_counters.vibes++;
+}
+
+void vibes_long_pulse(void)
+{
+    host_counters.vibes++;
+}
+
+void vibes_double_pulse(void)
+{
+    host_counters.vibes++;
+}
+
+void vibes_enqueue_custom_pattern(VibePattern pattern)
+{
+    host_counters.vibes++;
+}
+
+// ------------------------- Wakeup -----------------------------
+
+#define HOST_MAX_WAKEUPS 8
+#define HOST_WAKEUP_SPACING_SEC 60
+
+static time_t s_wakeups[HOST_MAX_WAKEUPS];  // Zero if unused
+static int32_t s_wakeup_cookies[HOST_MAX_WAKEUPS];
+
+WakeupId wakeup_schedule(time_t timestamp, int32_t cookie, bool notify_if_missed)
+{
+    int slot = -1;
+
+    for (int i = 0; i < HOST_MAX_WAKEUPS; i++)
+    {
+        if (!s_wakeups[i])
+        {
+            slot = slot < 0 ? i : slot;
+        }
+        else if (s_wakeups[i] > timestamp - HOST_WAKEUP_SPACING_SEC && s_wakeups[i] < timestamp + HOST_WAKEUP_SPACING_SEC)
+        {
+            return E_RANGE;
+        }
+    }
+
+    if (slot < 0)
+    {
+        return E_OUT_OF_RESOURCES;
+    }
+
+    s_wakeups[slot] = timestamp;
+    s_wakeup_cookies[slot] = cookie;
+    host_counters.wakeups++;
+    return slot + 1;
+}
+
+void wakeup_cancel(WakeupId wakeup_id)
+{
+    if (wakeup_id > 0 && wakeup_id <= HOST_MAX_WAKEUPS)
+    {
+        s_wakeups[wakeup_id - 1] = 0;
+    }
+}
+
+void wakeup_cancel_all(void)
+{
+    memset(s_wakeups, 0, sizeof(s_wakeups));
+}
+
+bool wakeup_query(WakeupId wakeup_id, time_t *timestamp)
+{
+    if (wakeup_id <= 0 || wakeup_id > HOST_MAX_WAKEUPS || !s_wakeups[wakeup_id - 1])
+    {
+        return false;
+    }
+
+    if (timestamp)
+    {
+        *timestamp = s_wakeups[wakeup_id - 1];
+    }
+    return true;
+}
+
+static int host_wakeup_earliest(void)
+{
+    int earliest = -1;
+
+    for (int i = 0; i < HOST_MAX_WAKEUPS; i++)
+    {
+        if (s_wakeups[i] && (earliest < 0 || s_wakeups[i] < s_wakeups[earliest]))
+        {
+            earliest = i;
+        }
+    }
+
+    return earliest;
+}
+
+bool host_wakeup_next(time_t *timestamp)
+{
+    int earliest = host_wakeup_earliest();
+
+    if (earliest < 0)
+    {
+        return false;
+    }
+
+    *timestamp = s_wakeups[earliest];
+    return true;
+}
+
+WakeupId host_wakeup_fire(int32_t *cookie)
+{
+    int earliest = host_wakeup_earliest();
+
+    if (earliest < 0)
+    {
+        return -1;
+    }
+
+    s_wakeups[earliest] = 0;
+    *cookie = s_wakeup_cookies[earliest];
+    return earliest + 1;
+}
+
+// ------------------------- App Message ------------------------
+
+#define HOST_APP_MESSAGE_ACK_MS     200
+#define HOST_DICT_HEADER_SIZE       1       // Tuple count
+#define HOST_TUPLE_HEADER_SIZE      7       // Key, type and length
+
+struct DictionaryIterator
+{
+    uint32_t used;
+    uint8_t count;
+};
+
+static uint32_t s_outbox_size;      // 0 while App Message is closed
+static DictionaryIterator s_outbox;
+static bool s_outbox_begun;
+static AppTimer *s_outbox_ack;      // Message on its way, until the phone takes it
+static AppMessageOutboxSent s_outbox_sent;
+static AppMessageOutboxFailed s_outbox_failed;
+
+uint32_t dict_calc_buffer_size(const uint8_t tuple_count, ...)
+{
+    uint32_t size = HOST_DICT_HEADER_SIZE + tuple_count * HOST_TUPLE_HEADER_SIZE;
+    va_list args;
+    va_start(args, tuple_count);
+
+    for (int i = 0; i < tuple_count; i++)
+    {
+        size += va_arg(args, uint32_t);
+    }
+
+    va_end(args);
+    return size;
+}
+
+static DictionaryResult dict_write(DictionaryIterator *iter, uint32_t size)
+{
+    if (!iter)
+    {
+        return DICT_INVALID_ARGS;
+    }
+
+    if (iter->used + HOST_TUPLE_HEADER_SIZE + size > s_outbox_size)
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "dict_write %u bytes do not fit the outbox of %u",
+                (unsigned)(iter->used + HOST_TUPLE_HEADER_SIZE + size), (unsigned)s_outbox_size);
+        return DICT_NOT_ENOUGH_STORAGE;
+    }
+
+    iter->used += HOST_TUPLE_HEADER_SIZE + size;
+    iter->count++;
+    return DICT_OK;
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value)
+{
+    return dict_write(iter, sizeof(value));
+}
+
+DictionaryResult dict_write_uint16(DictionaryIterator *iter, const uint32_t key, const uint16_t value)
+{
+    return dict_write(iter, sizeof(value));
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value)
+{
+    return dict_write(iter, sizeof(value));
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *const cstring)
+{
+    return dict_write(iter, cstring ? strlen(cstring) + 1 : 0);
+}
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound)
+{
+    s_outbox_size = size_outbound;
+    return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator)
+{
+    if (!s_outbox_size)
+    {
+        return APP_MSG_INVALID_STATE;
+    }
+
+    if (s_outbox_begun || s_outbox_ack)
+    {
+        return APP_MSG_BUSY;
+    }
+
+    s_outbox = (DictionaryIterator){ .used = HOST_DICT_HEADER_SIZE };
+    s_outbox_begun = true;
+    *iterator = &s_outbox;
+    return APP_MSG_OK;
+}
+
+static void app_message_ack(void *data)
+{
+    s_outbox_ack = NULL;
+
+    if (s_outbox_sent)
+    {
+        s_outbox_sent(&s_outbox, NULL);
+    }
+}
+
+AppMessageResult app_message_outbox_send(void)
+{
+    if (!s_outbox_begun)
+    {
+        return APP_MSG_INVALID_STATE;
+    }
+
+    s_outbox_begun = false;
+    s_outbox_ack = app_timer_register(HOST_APP_MESSAGE_ACK_MS, app_message_ack, NULL);
+    host_counters.messages++;
+    host_counters.message_bytes += s_outbox.used;
+    return APP_MSG_OK;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback)
+{
+    AppMessageOutboxSent previous = s_outbox_sent;
+    s_outbox_sent = sent_callback;
+    return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback)
+{
+    AppMessageOutboxFailed previous = s_outbox_failed;
+    s_outbox_failed = failed_callback;
+    return previous;
+}
+
+// As the app closes; a message still on its way is forgotten
+void app_message_deregister_callbacks(void)
+{
+    app_timer_cancel(s_outbox_ack);
+    s_outbox_ack = NULL;
+    s_outbox_begun = false;
+    s_outbox_sent = NULL;
+    s_outbox_failed = NULL;
+    s_outbox_size = 0;
+}
+
+// ------------------------- Graphics ---------------------------
+
+struct GBitmap
+{
+    GBitmapFormat format;
+    uint16_t bytes_per_row;
+    GRect bounds;
+    uint8_t *data;          // Points into the parent's pixels for a sub-bitmap
+    GColor *palette;
+    bool owns_data;
+    bool owns_palette;
+};
+
+static uint16_t gbitmap_row_bytes(int16_t w, GBitmapFormat format)
+{
+    switch (format)
+    {
+        case GBitmapFormat1Bit:
+            return (w + 31) / 32 * 4;
+        case GBitmapFormat1BitPalette:
+            return (w + 7) / 8;
+        case GBitmapFormat2BitPalette:
+            return (w * 2 + 7) / 8;
+        case GBitmapFormat4BitPalette:
+            return (w * 4 + 7) / 8;
+        default:
+            return w;
+    }
+}
+
+GBitmap *gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor *palette,
+                                           bool free_on_destroy)
+{
+    GBitmap *bitmap = calloc(1, sizeof(GBitmap));
+
+    if (!bitmap)
+    {
+        return NULL;
+    }
+
+    bitmap->format = format;
+    bitmap->bytes_per_row = gbitmap_row_bytes(size.w, format);
+    bitmap->bounds = (GRect){ { 0, 0 }, size };
+    bitmap->data = calloc(size.h, bitmap->bytes_per_row);
+    bitmap->owns_data = true;
+    bitmap->palette = palette;
+    bitmap->owns_palette = free_on_destroy;
+
+    if (!bitmap->data)
+    {
+        free(bitmap);
+        return NULL;
+    }
+
+    host_counters.bitmaps_loaded++;
+    return bitmap;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format)
+{
+    return gbitmap_create_blank_with_palette(size, format, NULL, false);
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap, GRect sub_rect)
+{
+    GBitmap *bitmap = malloc(sizeof(GBitmap));
+
+    if (!bitmap)
+    {
+        return NULL;
+    }
+
+    // shares the pixels and palette; the bounds say which part to draw
+    *bitmap = *base_bitmap;
+    bitmap->bounds = sub_rect;
+    bitmap->owns_data = false;
+    bitmap->owns_palette = false;
+    return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap)
+{
+    if (bitmap)
+    {
+        if (bitmap->owns_data)
+        {
+            free(bitmap->data);
+        }
+        if (bitmap->owns_palette)
+        {
+            free(bitmap->palette);
+        }
+        free(bitmap);
+    }
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap)
+{
+    return bitmap->data;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap)
+{
+    return bitmap->format;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap)
+{
+    return bitmap->bytes_per_row;
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap)
+{
+    return bitmap->bounds;
+}
+
+// ------------------------- Resources --------------------------
+
+#ifndef HOST_ICON_ATLAS
+#define HOST_ICON_ATLAS "icon_atlas.bin"
+#endif
+
+static uint8_t *s_atlas;
+static size_t s_atlas_size;
+
+ResHandle resource_get_handle(uint32_t resource_id)
+{
+    if (resource_id != RESOURCE_ID_ICON_ATLAS)
+    {
+        return NULL;
+    }
+
+    if (!s_atlas)
+    {
+        FILE *f = fopen(HOST_ICON_ATLAS, "rb");
+
+        if (!f)
+        {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "resource_get_handle cannot open %s", HOST_ICON_ATLAS);
+            return NULL;
+        }
+
+        fseek(f, 0, SEEK_END);
+        s_atlas_size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        s_atlas = malloc(s_atlas_size);
+
+        if (!s_atlas || fread(s_atlas, 1, s_atlas_size, f) != s_atlas_size)
+        {
+            free(s_atlas);
+            s_atlas = NULL;
+            s_atlas_size = 0;
+        }
+
+        fclose(f);
+    }
+
+    return s_atlas;
+}
+
+size_t resource_size(ResHandle h)
+{
+    return h ? s_atlas_size : 0;
+}
+
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t *buffer, size_t num_bytes)
+{
+    if (!h || start_offset >= s_atlas_size)
+    {
+        return 0;
+    }
+
+    if (num_bytes > s_atlas_size - start_offset)
+    {
+        num_bytes = s_atlas_size - start_offset;
+    }
+
+    memcpy(buffer, s_atlas + start_offset, num_bytes);
+    host_counters.resource_bytes += num_bytes;
+    return num_bytes;
+}
+
+// ------------------------- Heap -------------------------------
+
+size_t heap_bytes_free(void)
+{
+    return host_heap_free;
+}
+
+size_t heap_bytes_used(void)
+{
+    return 0;
+}
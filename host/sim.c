@@ -0,0 +1,946 @@
+// Discrete-event simulator for the timer core. Replays a scripted workload of timer
+// use against a virtual clock, jumping straight from one event to the next (script
+// step, AppTimer, tick, wakeup), so days of use run in well under a second.
+//
+//   build/basalt/sim workloads/month.sim
+//   build/basalt/sim -e workloads/energy-idle.sim     # energy use per hour only
+//
+// The app layer below stands in for the windows in timer.c. The tick rate, the row
+// cache and its updates are timer_view.c, as on the watch; the app saves and plans
+// the wakeups on exit and restores on launch. Timeline pins go out through outbox.c
+// to a phone that takes every message. All menu rows are taken to be on
+// screen, so the redraw count is an upper bound. Ticks, redraws, flash writes,
+// wakeups and motor time are read from the energy counters. A wakeup launches the
+// app SIM_LAUNCH_LATENCY_MS after it fires.
+//
+// Workload format, one step per line, '#' starts a comment:
+//
+//   <time> <command> [args]
+//
+// <time> is an offset from the start of the run (or of the enclosing repeat block),
+// or relative to the previous step when prefixed with '+'. Durations are written
+// as 1d2h30m15s; a bare number is seconds.
+//
+//   launch                 open the app
+//   exit                   close the app, planning its wakeups
+//   add timer <duration>   add a countdown
+//   add stopwatch          add a stopwatch
+//   start <n>              start timer n (index in creation order)
+//   stop <n>
+//   reset <n>
+//   open <n>               show timer n in its own window
+//   close                  back to the menu
+//   autoexit <duration>    how long the app stays open after a wakeup launch
+//   quit                   end of the run
+//   repeat <count> <period> ... done
+//
+// Any command other than launch, exit, autoexit and quit opens the app first if it
+// is closed, as the user would.
+
+#include <pebble.h>
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include "timer_core.h"
+#include "timer_view.h"
+#include "energy.h"
+#include "wakeup_plan.h"
+#include "outbox.h"
+
+#define SIM_EPOCH           1767571200LL    // Monday 2026-01-05 00:00 UTC
+#define SIM_AUTOEXIT_MS     (2 * 60 * 1000)
+#define SIM_LAUNCH_LATENCY_MS 1500          // From a wakeup firing to the app being up
+#define SIM_MAX_LINES       4096
+
+// ------------------------- Workload ---------------------------
+
+typedef enum
+{
+    CMD_LAUNCH,
+    CMD_EXIT,
+    CMD_ADD_TIMER,
+    CMD_ADD_STOPWATCH,
+    CMD_START,
+    CMD_STOP,
+    CMD_RESET,
+    CMD_OPEN,
+    CMD_CLOSE,
+    CMD_AUTOEXIT,
+    CMD_QUIT,
+} SimCommand;
+
+typedef struct
+{
+    int64_t at;             // ms since the start of the run
+    int seq;                // Order in the script, to keep sorting stable
+    SimCommand cmd;
+    int timer;
+    uint32_t sec;
+    int line;
+} SimEvent;
+
+static char *s_lines[SIM_MAX_LINES];
+static int s_line_nums[SIM_MAX_LINES];
+static int s_num_lines = 0;
+
+static SimEvent *s_events = NULL;
+static int s_num_events = 0;
+static int s_events_size = 0;
+
+static const char *s_workload = "";
+
+static void sim_fail(int line, const char *msg)
+{
+    fprintf(stderr, "%s:%d: %s\n", s_workload, line, msg);
+    exit(1);
+}
+
+// Parse 1d2h30m15s into seconds; false if malformed
+static bool parse_duration(const char *s, uint32_t *sec)
+{
+    uint32_t total = 0;
+
+    if (!*s)
+    {
+        return false;
+    }
+
+    while (*s)
+    {
+        if (!isdigit((unsigned char)*s))
+        {
+            return false;
+        }
+
+        uint32_t value = strtoul(s, (char **)&s, 10);
+
+        switch (*s)
+        {
+            case 'd': value *= SECONDS_PER_DAY; s++; break;
+            case 'h': value *= 60 * 60; s++; break;
+            case 'm': value *= 60; s++; break;
+            case 's': s++; break;
+            case '\0': break;
+            default: return false;
+        }
+
+        total += value;
+    }
+
+    *sec = total;
+    return true;
+}
+
+static void event_add(SimEvent event)
+{
+    if (s_num_events == s_events_size)
+    {
+        s_events_size = s_events_size ? s_events_size * 2 : 256;
+        s_events = realloc(s_events, s_events_size * sizeof(SimEvent));
+
+        if (!s_events)
+        {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+
+    event.seq = s_num_events;
+    s_events[s_num_events++] = event;
+}
+
+static int parse_timer_arg(const char *arg, int line)
+{
+    char *end;
+    long timer = arg ? strtol(arg, &end, 10) : -1;
+
+    if (!arg || *end || timer < 0 || timer >= MAX_TIMERS)
+    {
+        sim_fail(line, "expected a timer number");
+    }
+
+    return timer;
+}
+
+// Expand lines from *i until 'done' or the end, with offsets from base; the time of
+// the last step is kept in *last for relative offsets
+static void parse_block(int *i, int64_t base, int64_t *last, bool nested)
+{
+    while (*i < s_num_lines)
+    {
+        int line = s_line_nums[*i];
+        char buf[256];
+        snprintf(buf, sizeof(buf), "%s", s_lines[(*i)++]);
+
+        char *words[4] = { NULL };
+        int num_words = 0;
+
+        for (char *w = strtok(buf, " \t"); w && num_words < 4; w = strtok(NULL, " \t"))
+        {
+            words[num_words++] = w;
+        }
+
+        if (strcmp(words[0], "done") == 0)
+        {
+            if (!nested)
+            {
+                sim_fail(line, "'done' without 'repeat'");
+            }
+            return;
+        }
+
+        uint32_t offset;
+        bool relative = words[0][0] == '+';
+
+        if (num_words < 2 || !parse_duration(words[0] + relative, &offset))
+        {
+            sim_fail(line, "expected <time> <command>");
+        }
+
+        SimEvent event = { .at = (relative ? *last : base) + offset * 1000LL, .line = line };
+        const char *cmd = words[1];
+        *last = event.at;
+
+        if (strcmp(cmd, "repeat") == 0)
+        {
+            uint32_t count, period;
+
+            if (num_words < 4 || !parse_duration(words[3], &period) || !(count = strtoul(words[2], NULL, 10)))
+            {
+                sim_fail(line, "expected repeat <count> <period>");
+            }
+
+            int start = *i;
+
+            for (uint32_t n = 0; n < count; n++)
+            {
+                *i = start;
+                int64_t block_last = event.at + n * period * 1000LL;
+                parse_block(i, block_last, &block_last, true);
+                *last = block_last;
+            }
+            continue;
+        }
+
+        if (strcmp(cmd, "launch") == 0)
+        {
+            event.cmd = CMD_LAUNCH;
+        }
+        else if (strcmp(cmd, "exit") == 0)
+        {
+            event.cmd = CMD_EXIT;
+        }
+        else if (strcmp(cmd, "add") == 0 && words[2] && strcmp(words[2], "stopwatch") == 0)
+        {
+            event.cmd = CMD_ADD_STOPWATCH;
+        }
+        else if (strcmp(cmd, "add") == 0 && words[2] && strcmp(words[2], "timer") == 0)
+        {
+            event.cmd = CMD_ADD_TIMER;
+
+            if (!words[3] || !parse_duration(words[3], &event.sec) || event.sec == 0)
+            {
+                sim_fail(line, "expected add timer <duration>");
+            }
+        }
+        else if (strcmp(cmd, "start") == 0 || strcmp(cmd, "stop") == 0 ||
+                 strcmp(cmd, "reset") == 0 || strcmp(cmd, "open") == 0)
+        {
+            event.cmd = cmd[0] == 'o' ? CMD_OPEN : cmd[0] == 'r' ? CMD_RESET :
+                        cmd[3] == 'r' ? CMD_START : CMD_STOP;
+            event.timer = parse_timer_arg(words[2], line);
+        }
+        else if (strcmp(cmd, "close") == 0)
+        {
+            event.cmd = CMD_CLOSE;
+        }
+        else if (strcmp(cmd, "autoexit") == 0)
+        {
+            event.cmd = CMD_AUTOEXIT;
+
+            if (!words[2] || !parse_duration(words[2], &event.sec))
+            {
+                sim_fail(line, "expected autoexit <duration>");
+            }
+        }
+        else if (strcmp(cmd, "quit") == 0)
+        {
+            event.cmd = CMD_QUIT;
+        }
+        else
+        {
+            sim_fail(line, "unknown command");
+        }
+
+        event_add(event);
+    }
+
+    if (nested)
+    {
+        sim_fail(s_line_nums[s_num_lines - 1], "'repeat' without 'done'");
+    }
+}
+
+static int event_compare(const void *a, const void *b)
+{
+    const SimEvent *x = a, *y = b;
+
+    if (x->at != y->at)
+    {
+        return x->at < y->at ? -1 : 1;
+    }
+
+    return x->seq - y->seq;
+}
+
+static void workload_load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+
+    if (!f)
+    {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+
+    char buf[256];
+
+    for (int line = 1; fgets(buf, sizeof(buf), f); line++)
+    {
+        char *comment = strchr(buf, '#');
+        if (comment)
+        {
+            *comment = '\0';
+        }
+
+        char *start = buf;
+        while (isspace((unsigned char)*start))
+        {
+            start++;
+        }
+
+        char *end = start + strlen(start);
+        while (end > start && isspace((unsigned char)end[-1]))
+        {
+            *--end = '\0';
+        }
+
+        if (!*start)
+        {
+            continue;
+        }
+
+        if (s_num_lines == SIM_MAX_LINES)
+        {
+            sim_fail(line, "too many lines");
+        }
+
+        s_line_nums[s_num_lines] = line;
+        s_lines[s_num_lines++] = strdup(start);
+    }
+
+    fclose(f);
+
+    int i = 0;
+    int64_t last = 0;
+    parse_block(&i, 0, &last, false);
+
+    qsort(s_events, s_num_events, sizeof(SimEvent), event_compare);
+}
+
+// ------------------------- Statistics -------------------------
+
+typedef struct
+{
+    int64_t deadline;       // When the running countdown should expire, or -1
+    int64_t remaining_ms;   // Left on the countdown while it is stopped
+    int64_t total_ms;
+    uint32_t expiries;
+    uint32_t missed;
+    int64_t error_sum;      // Sum of |actual - deadline| in ms
+    int64_t error_max;
+    bool used;
+    bool stopwatch;
+} SimTimerStats;
+
+static SimTimerStats s_stats[MAX_TIMERS];
+
+static struct
+{
+    uint32_t launches;
+    uint32_t wakeup_launches;
+} s_sim;
+
+static int64_t sim_now(void)
+{
+    return host_now_ms() - SIM_EPOCH * 1000;
+}
+
+// The deadlines are kept in wall-clock ms from the script's own starts and stops,
+// not read back from the core, so expiry error shows drift and late firing.
+static void stats_start(int timer)
+{
+    SimTimerStats *stats = &s_stats[timer];
+
+    if (!stats->stopwatch && stats->deadline < 0)
+    {
+        stats->deadline = host_now_ms() + stats->remaining_ms;
+    }
+}
+
+static void stats_stop(int timer)
+{
+    SimTimerStats *stats = &s_stats[timer];
+
+    if (stats->deadline >= 0)
+    {
+        stats->remaining_ms = stats->deadline - host_now_ms();
+        stats->deadline = -1;
+    }
+}
+
+static void stats_reset(int timer)
+{
+    SimTimerStats *stats = &s_stats[timer];
+
+    stats->remaining_ms = stats->total_ms;
+    if (stats->deadline >= 0)
+    {
+        stats->deadline = host_now_ms() + stats->total_ms;
+    }
+}
+
+// ------------------------- App --------------------------------
+//
+// Stand-in for the UI in timer.c.
+
+static bool s_app_open = false;
+static int s_focused = -1;
+static int64_t s_autoexit_ms = SIM_AUTOEXIT_MS;
+static int64_t s_autoexit_at = -1;  // Virtual time the wakeup-launched app closes, or -1
+static bool s_verbose = false;
+
+// The timer window redraws its time on every tick while its timer runs
+static void app_tick(void)
+{
+    if (s_focused >= 0 && timer_is_running(s_focused))
+    {
+        ENERGY_COUNT(redraws, 1);
+    }
+}
+
+static void app_rows_changed(void)
+{
+    ENERGY_COUNT(redraws, 1);
+}
+
+// As timeline_pin in timer.c, without the title
+static bool app_timeline_pin(uint16_t id, time_t *deadline, char *title, size_t size)
+{
+    int timer = timer_from_id(id);
+
+    if (timer < 0 || !timer_is_running(timer) || timer_is_counting_up(timer))
+    {
+        return false;
+    }
+
+    *deadline = time(NULL) + timer_remaining_sec(timer);
+    snprintf(title, size, "timer %d", timer);
+    return true;
+}
+
+static void app_timeline_update(int timer)
+{
+    if (!timer_is_counting_up(timer))
+    {
+        outbox_timeline_update(timer_id(timer));
+    }
+}
+
+static void app_expired(int timer)
+{
+    SimTimerStats *stats = &s_stats[timer];
+    int64_t error = stats->deadline >= 0 ? host_now_ms() - stats->deadline : 0;
+
+    if (error < 0)
+    {
+        error = -error;
+    }
+
+    stats->expiries++;
+    stats->error_sum += error;
+    if (error > stats->error_max)
+    {
+        stats->error_max = error;
+    }
+    stats->deadline = -1;
+    stats->remaining_ms = stats->total_ms;
+
+    if (s_verbose)
+    {
+        printf("%10.3f  timer %d expired, off by %" PRId64 " ms\n", sim_now() / 1000.0, timer, error);
+    }
+
+    timer_row_invalidate(timer);
+}
+
+static void app_alerted(int timer)
+{
+    timer_row_invalidate(timer);
+}
+
+static void app_fired(void)
+{
+    ENERGY_COUNT(redraws, 1);
+    timer_view_schedule();
+}
+
+// launched_by is the wakeup that launched the app, or -1 if the user did
+static void app_launch(WakeupId launched_by)
+{
+    if (s_app_open)
+    {
+        return;
+    }
+
+    s_app_open = true;
+    s_sim.launches++;
+
+    if (launched_by >= 0)
+    {
+        s_sim.wakeup_launches++;
+        vibes_short_pulse();
+        s_autoexit_at = host_now_ms() + s_autoexit_ms;
+    }
+
+    timer_view_init((TimerViewHandlers){
+        .tick = app_tick,
+        .rows_changed = app_rows_changed,
+    });
+    timer_core_init((TimerCoreHandlers){
+        .pool_resized = timer_rows_resize,
+        .expired = app_expired,
+        .alerted = app_alerted,
+        .fired = app_fired,
+    });
+    timer_core_load();
+
+    for (int i = 0; i < timer_slots; i++)
+    {
+        // the timers a fresh install starts with are first seen here
+        if (!s_stats[i].used && timer_is_used(i))
+        {
+            s_stats[i].total_ms = (int64_t)timers[i].total_sec * 1000;
+            s_stats[i].remaining_ms = s_stats[i].total_ms;
+        }
+        s_stats[i].used = timer_is_used(i);
+        s_stats[i].stopwatch = timer_is_counting_up(i);
+    }
+
+    timer_rows_invalidate_all();
+    wakeup_plan_launch(launched_by);
+
+    outbox_init((OutboxHandlers){
+        .pin = app_timeline_pin,
+    });
+
+    for (int i = 0; i < timer_slots; i++)
+    {
+        if (timer_is_running(i))
+        {
+            app_timeline_update(i);
+        }
+    }
+
+    s_focused = -1;
+    timer_view_schedule();
+    ENERGY_COUNT(redraws, 1);
+
+    if (s_verbose)
+    {
+        printf("%10.3f  launch%s\n", sim_now() / 1000.0, launched_by >= 0 ? " (wakeup)" : "");
+    }
+}
+
+static void app_exit(void)
+{
+    if (!s_app_open)
+    {
+        return;
+    }
+
+    store_set_selection(0, 0);
+    wakeup_plan_schedule();
+
+    timer_view_deinit();
+    timer_core_deinit();
+    outbox_deinit();
+    host_app_timer_reset();
+
+    s_app_open = false;
+    s_focused = -1;
+    s_autoexit_at = -1;
+
+    if (s_verbose)
+    {
+        printf("%10.3f  exit\n", sim_now() / 1000.0);
+    }
+}
+
+static void app_wakeup(void)
+{
+    int32_t cookie;
+    WakeupId wakeup_id = host_wakeup_fire(&cookie);
+
+    if (!s_app_open)
+    {
+        app_launch(wakeup_id);
+    }
+    else if (s_verbose)
+    {
+        printf("%10.3f  wakeup for timer %d while open\n", sim_now() / 1000.0, (int)cookie);
+    }
+}
+
+static void app_run(const SimEvent *event)
+{
+    if (event->cmd != CMD_LAUNCH && event->cmd != CMD_EXIT &&
+        event->cmd != CMD_AUTOEXIT && event->cmd != CMD_QUIT)
+    {
+        app_launch(-1);
+        // the user is using the app, so it no longer closes by itself
+        s_autoexit_at = -1;
+    }
+
+    if ((event->cmd == CMD_START || event->cmd == CMD_STOP || event->cmd == CMD_RESET ||
+         event->cmd == CMD_OPEN) && !timer_is_used(event->timer))
+    {
+        sim_fail(event->line, "no such timer");
+    }
+
+    int timer = event->timer;
+
+    switch (event->cmd)
+    {
+        case CMD_LAUNCH:
+            app_launch(-1);
+            break;
+
+        case CMD_EXIT:
+            app_exit();
+            break;
+
+        case CMD_ADD_TIMER:
+        case CMD_ADD_STOPWATCH:
+            timer = timer_add(event->cmd == CMD_ADD_STOPWATCH);
+            if (timer < 0)
+            {
+                sim_fail(event->line, "timer pool is full");
+            }
+            if (event->cmd == CMD_ADD_TIMER)
+            {
+                timer_set_total_sec(timer, event->sec);
+            }
+            s_stats[timer] = (SimTimerStats){ .deadline = -1, .used = true,
+                                              .stopwatch = event->cmd == CMD_ADD_STOPWATCH };
+            s_stats[timer].total_ms = (int64_t)event->sec * 1000;
+            s_stats[timer].remaining_ms = s_stats[timer].total_ms;
+            timer_row_invalidate(timer);
+            break;
+
+        case CMD_START:
+            if (!timer_is_running(timer))
+            {
+                if (timer_start(timer))
+                {
+                    stats_start(timer);
+                    app_timeline_update(timer);
+                }
+                else
+                {
+                    vibes_double_pulse();
+                }
+            }
+            timer_row_invalidate(timer);
+            break;
+
+        case CMD_STOP:
+            if (timer_is_running(timer))
+            {
+                timer_stop(timer);
+                stats_stop(timer);
+                app_timeline_update(timer);
+            }
+            timer_row_invalidate(timer);
+            break;
+
+        case CMD_RESET:
+            timer_reset(timer);
+            stats_reset(timer);
+            timer_row_invalidate(timer);
+            break;
+
+        case CMD_OPEN:
+            s_focused = timer;
+            timer_view_set_focus(timer);
+            break;
+
+        case CMD_CLOSE:
+            s_focused = -1;
+            timer_view_set_focus(-1);
+            break;
+
+        case CMD_AUTOEXIT:
+            s_autoexit_ms = event->sec * 1000LL;
+            break;
+
+        case CMD_QUIT:
+            break;
+    }
+
+    if (s_app_open && event->cmd != CMD_AUTOEXIT && event->cmd != CMD_QUIT)
+    {
+        ENERGY_COUNT(redraws, 1);
+        timer_view_schedule();
+    }
+}
+
+// ------------------------- Event Loop -------------------------
+
+typedef enum
+{
+    SOURCE_NONE,
+    SOURCE_SCRIPT,
+    SOURCE_AUTOEXIT,
+    SOURCE_APP_TIMER,
+    SOURCE_TICK,
+    SOURCE_WAKEUP,
+} SimSource;
+
+static void sim_run(int64_t end)
+{
+    int next_event = 0;
+
+    for (;;)
+    {
+        int64_t next = INT64_MAX;
+        int64_t due;
+        SimSource source = SOURCE_NONE;
+
+        // on a tie the source listed first goes first
+        if (next_event < s_num_events)
+        {
+            next = SIM_EPOCH * 1000 + s_events[next_event].at;
+            source = SOURCE_SCRIPT;
+        }
+        if (s_autoexit_at >= 0 && s_autoexit_at < next)
+        {
+            next = s_autoexit_at;
+            source = SOURCE_AUTOEXIT;
+        }
+        if (s_app_open && host_app_timer_next(&due) && due < next)
+        {
+            next = due;
+            source = SOURCE_APP_TIMER;
+        }
+        if (s_app_open && host_tick_next(&due) && due < next)
+        {
+            next = due;
+            source = SOURCE_TICK;
+        }
+
+        // a wakeup launches the app a little after it fires; an open app is only told
+        time_t wake_time;
+        if (host_wakeup_next(&wake_time) &&
+            wake_time * 1000LL + (s_app_open ? 0 : SIM_LAUNCH_LATENCY_MS) < next)
+        {
+            next = wake_time * 1000LL + (s_app_open ? 0 : SIM_LAUNCH_LATENCY_MS);
+            source = SOURCE_WAKEUP;
+        }
+
+        if (source == SOURCE_NONE || next > SIM_EPOCH * 1000 + end)
+        {
+            break;
+        }
+
+        if (next > host_now_ms())
+        {
+            host_set_now_ms(next);
+        }
+
+        switch (source)
+        {
+            case SOURCE_SCRIPT:
+                app_run(&s_events[next_event++]);
+                break;
+
+            case SOURCE_AUTOEXIT:
+                app_exit();
+                break;
+
+            case SOURCE_APP_TIMER:
+                host_app_timer_run();
+                break;
+
+            case SOURCE_TICK:
+                host_tick_run();
+                break;
+
+            case SOURCE_WAKEUP:
+                app_wakeup();
+                break;
+
+            case SOURCE_NONE:
+                break;
+        }
+    }
+
+    host_set_now_ms(SIM_EPOCH * 1000 + end);
+}
+
+// ------------------------- Report -----------------------------
+
+typedef struct
+{
+    const char *name;
+    size_t offset;
+} SimEnergyField;
+
+static const SimEnergyField s_energy_fields[] = {
+    { "ticks", offsetof(EnergyCounters, ticks) },
+    { "redraws", offsetof(EnergyCounters, redraws) },
+    { "reloads", offsetof(EnergyCounters, menu_reloads) },
+    { "writes", offsetof(EnergyCounters, persist_writes) },
+    { "write-bytes", offsetof(EnergyCounters, persist_bytes) },
+    { "sends", offsetof(EnergyCounters, outbox_sends) },
+    { "wakeups", offsetof(EnergyCounters, wakeups) },
+    { "vibe-ms", offsetof(EnergyCounters, vibe_ms) },
+};
+
+// One line of energy use per simulated hour, for comparing scenarios
+static void sim_report_energy(int64_t end)
+{
+    double hours = end / 3600000.0;
+    const char *name = strrchr(s_workload, '/') ? strrchr(s_workload, '/') + 1 : s_workload;
+
+    printf("%-20s", name);
+
+    for (const SimEnergyField *field = s_energy_fields; field < s_energy_fields + ARRAY_LENGTH(s_energy_fields); field++)
+    {
+        uint32_t value = *(const uint32_t *)((const uint8_t *)&energy + field->offset);
+        printf("  %s/h %.1f", field->name, hours > 0 ? value / hours : 0.0);
+    }
+
+    printf("\n");
+}
+
+static void sim_report(int64_t end, double wall_sec)
+{
+    uint32_t expiries = 0;
+    uint32_t missed = 0;
+    int64_t error_sum = 0;
+    int64_t error_max = 0;
+
+    printf("workload      %s\n", s_workload);
+    printf("simulated     %" PRId64 "d %02" PRId64 ":%02" PRId64 ":%02" PRId64 " in %.3f s\n",
+           end / 1000 / SECONDS_PER_DAY, end / 1000 / 3600 % 24, end / 1000 / 60 % 60, end / 1000 % 60, wall_sec);
+    printf("launches      %u (%u by wakeup)\n", s_sim.launches, s_sim.wakeup_launches);
+    printf("row renders   %u\n", timer_view_stats().renders);
+    printf("\n              total  per hour\n");
+
+    double hours = end / 3600000.0;
+    for (const SimEnergyField *field = s_energy_fields; field < s_energy_fields + ARRAY_LENGTH(s_energy_fields); field++)
+    {
+        uint32_t value = *(const uint32_t *)((const uint8_t *)&energy + field->offset);
+        printf("%-12s %6u  %8.1f\n", field->name, value, hours > 0 ? value / hours : 0.0);
+    }
+
+    printf("\n timer  kind       expiries  missed  mean err ms  max err ms\n");
+
+    for (int i = 0; i < MAX_TIMERS; i++)
+    {
+        SimTimerStats *stats = &s_stats[i];
+
+        // a countdown due before the end that never fired was missed
+        if (stats->deadline >= 0 && stats->deadline <= host_now_ms())
+        {
+            stats->missed++;
+        }
+
+        if (!stats->used)
+        {
+            continue;
+        }
+
+        printf(" %5d  %-9s  %8u  %6u  %11.1f  %10" PRId64 "\n", i,
+               stats->stopwatch ? "stopwatch" : "timer",
+               stats->expiries, stats->missed,
+               stats->expiries ? (double)stats->error_sum / stats->expiries : 0.0, stats->error_max);
+
+        expiries += stats->expiries;
+        missed += stats->missed;
+        error_sum += stats->error_sum;
+        if (stats->error_max > error_max)
+        {
+            error_max = stats->error_max;
+        }
+    }
+
+    printf("   all             %8u  %6u  %11.1f  %10" PRId64 "\n", expiries, missed,
+           expiries ? (double)error_sum / expiries : 0.0, error_max);
+}
+
+int main(int argc, char **argv)
+{
+    int arg = 1;
+    bool energy_only = false;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++)
+    {
+        if (strcmp(argv[arg], "-v") == 0)
+        {
+            s_verbose = true;
+        }
+        else if (strcmp(argv[arg], "-e") == 0)
+        {
+            energy_only = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (arg != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-v] [-e] <workload>\n", argv[0]);
+        return 2;
+    }
+
+    s_workload = argv[arg];
+    workload_load(s_workload);
+
+    int64_t end = s_num_events ? s_events[s_num_events - 1].at : 0;
+
+    for (int i = 0; i < MAX_TIMERS; i++)
+    {
+        s_stats[i].deadline = -1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    host_set_now_ms(SIM_EPOCH * 1000);
+    sim_run(end);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    if (energy_only)
+    {
+        sim_report_energy(end);
+    }
+    else
+    {
+        sim_report(end, (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    }
+    return 0;
+}
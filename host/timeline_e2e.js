@@ -0,0 +1,268 @@
+// End to end check of the timeline requests in pebble-js-app.js against
+// timeline_mock.js: batches from the watch go out as PUT and DELETE requests, offline
+// and refused-for-now requests are stored and replayed, a request refused for its token
+// is sent once more with a fresh one, and the stored queue keeps only the newest request
+// of each pin. The app runs with stand-ins for the PebbleKit JS globals, its timers
+// running TIME_SCALE times faster.
+//
+//   node timeline_e2e.js
+
+var fs = require('fs');
+var http = require('http');
+var path = require('path');
+var vm = require('vm');
+var createMock = require('./timeline_mock');
+
+var APP_JS = fs.readFileSync(path.join(__dirname, '../src/js/pebble-js-app.js'), 'utf8');
+var TIME_SCALE = 50;
+var VERBOSE = process.argv.indexOf('-v') >= 0;
+
+var COMMAND_TIMELINE_BATCH = 2;
+var KEY_BATCH_BASE = 300;
+var KEY_BATCH_STRIDE = 3;
+
+// localStorage as the phone keeps it between launches of the app
+function Storage() {
+  this.items = {};
+}
+Storage.prototype.getItem = function(key) { return key in this.items ? this.items[key] : null; };
+Storage.prototype.setItem = function(key, value) { this.items[key] = String(value); };
+Storage.prototype.removeItem = function(key) { delete this.items[key]; };
+
+// XMLHttpRequest over node's http, the parts the app uses
+function XMLHttpRequest() {
+  this.headers = {};
+  this.done = function(fn) { fn.call(this); };
+}
+XMLHttpRequest.prototype.open = function(method, url) {
+  this.method = method;
+  this.url = url;
+};
+XMLHttpRequest.prototype.setRequestHeader = function(name, value) {
+  this.headers[name] = value;
+};
+XMLHttpRequest.prototype.getResponseHeader = function(name) {
+  return this.response ? this.response.headers[name.toLowerCase()] || null : null;
+};
+XMLHttpRequest.prototype.send = function(body) {
+  var xhr = this;
+  var req = http.request(xhr.url, { method: xhr.method, headers: xhr.headers }, function(res) {
+    var text = '';
+    res.on('data', function(chunk) { text += chunk; });
+    res.on('end', function() {
+      xhr.response = res;
+      xhr.status = res.statusCode;
+      xhr.responseText = text;
+      xhr.done(xhr.onload);
+    });
+  });
+  req.on('error', function() {
+    xhr.status = 0;
+    xhr.done(xhr.onerror);
+  });
+  req.end(body);
+};
+
+// One launch of the app on the phone
+function launch(storage) {
+  var listeners = {};
+  var app = { tokenRequests: 0, closed: false };
+  // nothing reaches the app once it is closed
+  var later = function(fn, ms) {
+    return setTimeout(function() { if (!app.closed) fn(); }, ms);
+  };
+  var AppXMLHttpRequest = function() {
+    XMLHttpRequest.call(this);
+    var xhr = this;
+    xhr.done = function(fn) { if (!app.closed) fn.call(xhr); };
+  };
+  AppXMLHttpRequest.prototype = Object.create(XMLHttpRequest.prototype);
+
+  var context = {
+    console: { log: function(text) { if (VERBOSE) console.log('  js: ' + text); } },
+    localStorage: storage,
+    XMLHttpRequest: AppXMLHttpRequest,
+    setTimeout: function(fn, ms) { return later(fn, ms / TIME_SCALE); },
+    clearTimeout: clearTimeout,
+    Pebble: {
+      addEventListener: function(name, fn) { listeners[name] = fn; },
+      getTimelineToken: function(callback) {
+        app.tokenRequests++;
+        later(function() { callback('token'); }, 1);
+      },
+    },
+  };
+  vm.runInNewContext(APP_JS, context);
+
+  app.ready = function() { listeners.ready({}); };
+
+  // the app is closed; requests on their way are forgotten
+  app.close = function() { app.closed = true; };
+
+  // pins: [[id, deadline], ...], deadline 0 takes the pin off
+  app.send = function(pins) {
+    var payload = { KEY_COMMAND: COMMAND_TIMELINE_BATCH, KEY_BATCH_COUNT: pins.length };
+    pins.forEach(function(p, i) {
+      var key = KEY_BATCH_BASE + i * KEY_BATCH_STRIDE;
+      payload[key] = p[0];
+      payload[key + 1] = p[1];
+      if (p[1]) {
+        payload[key + 2] = 'Multi-Timer+ ' + p[0];
+      }
+    });
+    listeners.appmessage({ payload: payload });
+  };
+
+  app.stored = function() {
+    return JSON.parse(storage.getItem('timelineQueue') || '{}');
+  };
+
+  return app;
+}
+
+function waitFor(what, test, callback) {
+  var start = Date.now();
+  (function poll() {
+    if (test()) {
+      callback();
+    } else if (Date.now() - start > 5000) {
+      throw new Error('timed out waiting for ' + what);
+    } else {
+      setTimeout(poll, 5);
+    }
+  })();
+}
+
+function check(what, ok) {
+  console.log((ok ? 'ok   ' : 'FAIL ') + what);
+  if (!ok) {
+    process.exitCode = 1;
+  }
+}
+
+function idle(app) {
+  return function() { return Object.keys(app.stored()).length == 0; };
+}
+
+var DEADLINE = 2000000000;
+var mock = createMock();
+var scenarios = [];
+
+scenarios.push(function coalescing(next) {
+  var storage = new Storage();
+  storage.setItem('timelineApiRoot', 'http://127.0.0.1:' + mock.port + '/');
+  var app = launch(storage);
+  app.ready();
+  app.send([[1, DEADLINE], [2, DEADLINE]]);
+  app.send([[1, 0]]);
+  app.send([[1, DEADLINE + 60]]);
+  waitFor('coalesced batch', idle(app), function() {
+    var pin1 = mock.requests.filter(function(r) { return r.indexOf(' pin-1 ') > 0; });
+    check('three changes of a pin go out as one PUT', pin1.length == 1 && pin1[0] == 'PUT pin-1 200');
+    check('the newest deadline wins', mock.pins['pin-1'].time == new Date((DEADLINE + 60) * 1000).toISOString());
+    check('one token request for the session', app.tokenRequests == 1);
+    app.close();
+    next();
+  });
+});
+
+scenarios.push(function offlineReplay(next) {
+  var storage = new Storage();
+  storage.setItem('timelineApiRoot', 'http://127.0.0.1:' + mock.port + '/');
+  mock.close(function() {
+    var app = launch(storage);
+    app.ready();
+    app.send([[3, DEADLINE], [4, DEADLINE]]);
+    app.send([[3, 0], [5, DEADLINE]]);
+    waitFor('failed requests', function() { return app.tokenRequests > 0 && Object.keys(app.stored()).length == 3; }, function() {
+      var stored = app.stored();
+      check('offline requests are stored, newest per pin',
+            stored['pin-3'].type == 'DELETE' && stored['pin-4'].type == 'PUT' && stored['pin-5'].type == 'PUT');
+
+      // the app is closed while offline and launched again once the server is back
+      app.close();
+      mock.listen(mock.port, function() {
+        var relaunched = launch(storage);
+        relaunched.ready();
+        waitFor('replay on ready', idle(relaunched), function() {
+          check('stored requests are replayed on launch', mock.pins['pin-4'] && mock.pins['pin-5'] && !mock.pins['pin-3']);
+          relaunched.close();
+          next();
+        });
+      });
+    });
+  });
+});
+
+scenarios.push(function overloaded(next) {
+  var storage = new Storage();
+  storage.setItem('timelineApiRoot', 'http://127.0.0.1:' + mock.port + '/');
+  var app = launch(storage);
+  var before = mock.requests.length;
+  app.ready();
+  mock.faults = [429, 503, 500];
+  app.send([[6, DEADLINE]]);
+  waitFor('retries after 429 and 5xx', idle(app), function() {
+    var tries = mock.requests.slice(before);
+    check('429 and 5xx are retried until taken',
+          tries.join(',') == 'PUT pin-6 429,PUT pin-6 503,PUT pin-6 500,PUT pin-6 200');
+    check('pin is on the server', !!mock.pins['pin-6']);
+    app.close();
+    next();
+  });
+});
+
+scenarios.push(function refused(next) {
+  var storage = new Storage();
+  storage.setItem('timelineApiRoot', 'http://127.0.0.1:' + mock.port + '/');
+  var app = launch(storage);
+  var before = mock.requests.length;
+  app.ready();
+  mock.faults = [400];
+  app.send([[7, DEADLINE]]);
+  waitFor('refused request', idle(app), function() {
+    setTimeout(function() {
+      check('a 400 is dropped, not retried', mock.requests.slice(before).join(',') == 'PUT pin-7 400');
+      app.close();
+      next();
+    }, 200);
+  });
+});
+
+scenarios.push(function staleToken(next) {
+  var storage = new Storage();
+  storage.setItem('timelineApiRoot', 'http://127.0.0.1:' + mock.port + '/');
+  var app = launch(storage);
+  var before = mock.requests.length;
+  app.ready();
+  mock.faults = [401];
+  app.send([[8, DEADLINE]]);
+  waitFor('token retry', idle(app), function() {
+    check('a 401 is sent again once with a fresh token',
+          mock.requests.slice(before).join(',') == 'PUT pin-8 401,PUT pin-8 200' && !!mock.pins['pin-8']);
+    check('the token is asked for again', app.tokenRequests == 2);
+
+    before = mock.requests.length;
+    mock.faults = [403, 403];
+    app.send([[9, DEADLINE]]);
+    waitFor('refused again', idle(app), function() {
+      setTimeout(function() {
+        check('a second refusal drops the request',
+              mock.requests.slice(before).join(',') == 'PUT pin-9 403,PUT pin-9 403' && !mock.pins['pin-9']);
+        app.close();
+        next();
+      }, 200);
+    });
+  });
+});
+
+mock.listen(0, function() {
+  (function run(i) {
+    if (i == scenarios.length) {
+      mock.close();
+      return;
+    }
+    console.log(scenarios[i].name);
+    scenarios[i](function() { run(i + 1); });
+  })(0);
+});
@@ -0,0 +1,81 @@
+// Stand-in for the timeline web API, enough of it for pebble-js-app.js: PUT and DELETE
+// of /v1/user/pins/<id> with an X-User-Token header. Statuses queued in faults are
+// answered instead, one per request, to play an overloaded or failing server; a 429
+// comes with a Retry-After of one second.
+//
+//   node timeline_mock.js [port] [status...]   # e.g. node timeline_mock.js 8080 429 503
+//
+// Point the app at it by setting localStorage 'timelineApiRoot' to
+// 'http://<host>:<port>/'. timeline_e2e.js runs the app against it.
+
+var http = require('http');
+
+function createMock() {
+  var mock = {
+    pins: {},       // pin id -> pin JSON, as the server has them
+    requests: [],   // 'PUT pin-1 200', ... in the order answered
+    faults: [],     // Statuses to answer with next
+  };
+
+  mock.server = http.createServer(function(req, res) {
+    var body = '';
+    req.on('data', function(chunk) { body += chunk; });
+    req.on('end', function() {
+      var match = /^\/v1\/user\/pins\/([^\/]+)$/.exec(req.url);
+      var id = match ? decodeURIComponent(match[1]) : null;
+      var status = 200;
+      var headers = { 'Content-Type': 'text/plain' };
+
+      if (!match || (req.method != 'PUT' && req.method != 'DELETE')) {
+        status = 404;
+      } else if (!req.headers['x-user-token']) {
+        status = 401;
+      } else if (mock.faults.length) {
+        status = mock.faults.shift();
+        if (status == 429) {
+          headers['Retry-After'] = '1';
+        }
+      } else if (req.method == 'PUT') {
+        try {
+          mock.pins[id] = JSON.parse(body);
+        } catch (e) {
+          status = 400;
+        }
+      } else {
+        delete mock.pins[id];
+      }
+
+      mock.requests.push(req.method + ' ' + id + ' ' + status);
+      res.writeHead(status, headers);
+      res.end(status == 200 ? 'OK' : 'status ' + status);
+    });
+  });
+
+  mock.listen = function(port, callback) {
+    mock.server.listen(port, '127.0.0.1', function() {
+      mock.port = mock.server.address().port;
+      callback(mock.port);
+    });
+  };
+
+  mock.close = function(callback) {
+    mock.server.close(callback);
+  };
+
+  return mock;
+}
+
+module.exports = createMock;
+
+if (require.main === module) {
+  var mock = createMock();
+  mock.faults = process.argv.slice(3).map(Number);
+  mock.listen(Number(process.argv[2] || 8080), function(port) {
+    console.log('timeline mock on http://127.0.0.1:' + port + '/');
+  });
+  setInterval(function() {
+    while (mock.requests.length) {
+      console.log(mock.requests.shift());
+    }
+  }, 200);
+}
@@ -0,0 +1,127 @@
+#include "duration.h"
+
+typedef struct
+{
+    char *p;
+    char *end;  // Last byte of the buffer, kept for the terminator
+} DurationWriter;
+
+TimerDuration timer_duration(uint32_t sec)
+{
+    TimerDuration d;
+    uint32_t minutes = sec / 60;
+    uint32_t hours = minutes / 60;
+    d.days = hours / 24;
+    d.hours = hours - d.days * 24;
+    d.minutes = minutes - hours * 60;
+    d.seconds = sec - minutes * 60;
+    return d;
+}
+
+static void duration_put_char(DurationWriter *w, char c)
+{
+    if (w->p < w->end)
+    {
+        *w->p++ = c;
+    }
+}
+
+// value right aligned in at least width characters, as "%*d" or "%0*d" would
+static void duration_put_uint(DurationWriter *w, uint32_t value, int width, char pad)
+{
+    char digits[10];
+    int n = 0;
+
+    do
+    {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+
+    while (width-- > n)
+    {
+        duration_put_char(w, pad);
+    }
+
+    while (n > 0)
+    {
+        duration_put_char(w, digits[--n]);
+    }
+}
+
+// ":%02d"
+static void duration_put_field(DurationWriter *w, int value)
+{
+    duration_put_char(w, ':');
+    duration_put_uint(w, value, 2, '0');
+}
+
+size_t timer_format_duration(char *buf, size_t size, uint32_t sec, DurationStyle style)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    TimerDuration d = timer_duration(sec);
+    DurationWriter w = { buf, buf + size - 1 };
+
+    switch (style)
+    {
+        case DURATION_ROW:
+            if (d.days > 99)
+            {
+                // "%dd%02d"
+                duration_put_uint(&w, d.days, 1, ' ');
+                duration_put_char(&w, 'd');
+                duration_put_uint(&w, d.hours, 2, '0');
+                break;
+            }
+            if (d.days > 0)
+            {
+                // "%dd%02d:%02d"
+                duration_put_uint(&w, d.days, 1, ' ');
+                duration_put_char(&w, 'd');
+                duration_put_uint(&w, d.hours, 2, '0');
+                duration_put_field(&w, d.minutes);
+                break;
+            }
+            // under a day a row shows what the clock does
+            // fall through
+        case DURATION_CLOCK:
+            if (d.days > 0)
+            {
+                // "%2d %02d:%02d:%02d"
+                duration_put_uint(&w, d.days, 2, ' ');
+                duration_put_char(&w, ' ');
+                duration_put_uint(&w, d.hours, 2, '0');
+                duration_put_field(&w, d.minutes);
+            }
+            else if (d.hours > 0)
+            {
+                // "%2d:%02d:%02d"
+                duration_put_uint(&w, d.hours, 2, ' ');
+                duration_put_field(&w, d.minutes);
+            }
+            else
+            {
+                // "%2d:%02d"
+                duration_put_uint(&w, d.minutes, 2, ' ');
+            }
+            duration_put_field(&w, d.seconds);
+            break;
+        case DURATION_DAYS:
+            duration_put_uint(&w, d.days, 1, ' ');
+            break;
+        case DURATION_HOURS:
+            duration_put_uint(&w, d.hours, 2, '0');
+            break;
+        case DURATION_MIN_SEC:
+            duration_put_uint(&w, d.minutes, 2, '0');
+            duration_put_field(&w, d.seconds);
+            break;
+    }
+
+    *w.p = '\0';
+    return w.p - buf;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <pebble.h>
+
+// Splitting a number of seconds into days, hours, minutes and seconds, and printing
+// it in each of the ways the windows show a time. Menu rows are formatted for every
+// visible timer every second, so the split divides once per unit and the digits are
+// written by hand instead of going through snprintf.
+
+// Split of a number of seconds as the clock shows it
+typedef struct
+{
+    int days;
+    int hours;
+    int minutes;
+    int seconds;
+} TimerDuration;
+
+typedef enum
+{
+    DURATION_ROW,       // Menu row, less precise as it grows: "123d04" "1d04:05" " 4:05:06" " 5:06"
+    DURATION_CLOCK,     // Full precision: " 1 04:05:06" " 4:05:06" " 5:06"
+    DURATION_DAYS,      // Days alone: "1"
+    DURATION_HOURS,     // Hours of the day: "04"
+    DURATION_MIN_SEC,   // Minutes and seconds of the hour: "05:06"
+} DurationStyle;
+
+TimerDuration timer_duration(uint32_t sec);
+
+// Like snprintf: always terminated, cut short if size is too small. Returns the
+// length written, without the terminator.
+size_t timer_format_duration(char *buf, size_t size, uint32_t sec, DurationStyle style);
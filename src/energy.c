@@ -0,0 +1,33 @@
+#include <pebble.h>
+#include "energy.h"
+
+#ifdef ENERGY_COUNTERS
+
+EnergyCounters energy;
+
+void energy_reset(void)
+{
+    memset(&energy, 0, sizeof(energy));
+}
+
+void energy_dump(const char *label)
+{
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ energy %s ticks %d redraws %d reloads %d writes %d (%d bytes) sends %d wakeups %d vibe %d ms",
+            label, (int)energy.ticks, (int)energy.redraws, (int)energy.menu_reloads, (int)energy.persist_writes,
+            (int)energy.persist_bytes, (int)energy.outbox_sends, (int)energy.wakeups, (int)energy.vibe_ms);
+}
+
+// Motor time of a custom pattern: the even segments are on, the odd ones off
+uint32_t energy_vibe_pattern_ms(VibePattern pattern)
+{
+    uint32_t ms = 0;
+
+    for (uint32_t i = 0; i < pattern.num_segments; i += 2)
+    {
+        ms += pattern.durations[i];
+    }
+
+    return ms;
+}
+
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <pebble.h>
+
+// Counters for what costs battery: ticks, redraws, flash writes, radio traffic, wakeups
+// and motor time. They are only compiled in with ENERGY_COUNTERS, which the host build
+// always sets and the --energy build option in wscript sets for the watch; otherwise
+// they cost nothing. Include this after <pebble.h> in every file that makes one of
+// the calls.
+
+typedef struct
+{
+    uint32_t ticks;             // Tick handler calls
+    uint32_t redraws;           // layer_mark_dirty
+    uint32_t menu_reloads;      // menu_layer_reload_data
+    uint32_t persist_writes;    // persist_write_*
+    uint32_t persist_bytes;
+    uint32_t outbox_sends;      // app_message_outbox_send
+    uint32_t wakeups;           // wakeup_schedule
+    uint32_t vibe_ms;           // Motor on time
+} EnergyCounters;
+
+// Motor time of the canned pulses; the firmware does not publish them, so these are
+// estimates
+#define ENERGY_SHORT_PULSE_MS   100
+#define ENERGY_LONG_PULSE_MS    500
+
+#ifdef ENERGY_COUNTERS
+
+extern EnergyCounters energy;
+
+#define ENERGY_COUNT(field, n) (energy.field += (n))
+
+void energy_reset(void);
+void energy_dump(const char *label);
+uint32_t energy_vibe_pattern_ms(VibePattern pattern);
+
+// Shadow the counted SDK calls so no call site can be missed. A function-like macro
+// does not expand inside its own expansion, so each still calls the real function.
+#define layer_mark_dirty(layer) \
+    (ENERGY_COUNT(redraws, 1), layer_mark_dirty(layer))
+#define menu_layer_reload_data(menu_layer) \
+    (ENERGY_COUNT(menu_reloads, 1), menu_layer_reload_data(menu_layer))
+#define persist_write_int(key, value) \
+    (ENERGY_COUNT(persist_writes, 1), ENERGY_COUNT(persist_bytes, sizeof(int32_t)), persist_write_int(key, value))
+#define persist_write_data(key, data, size) \
+    (ENERGY_COUNT(persist_writes, 1), ENERGY_COUNT(persist_bytes, size), persist_write_data(key, data, size))
+#define app_message_outbox_send() \
+    (ENERGY_COUNT(outbox_sends, 1), app_message_outbox_send())
+#define wakeup_schedule(timestamp, cookie, notify_if_missed) \
+    (ENERGY_COUNT(wakeups, 1), wakeup_schedule(timestamp, cookie, notify_if_missed))
+#define vibes_short_pulse() \
+    (ENERGY_COUNT(vibe_ms, ENERGY_SHORT_PULSE_MS), vibes_short_pulse())
+#define vibes_long_pulse() \
+    (ENERGY_COUNT(vibe_ms, ENERGY_LONG_PULSE_MS), vibes_long_pulse())
+#define vibes_double_pulse() \
+    (ENERGY_COUNT(vibe_ms, 2 * ENERGY_SHORT_PULSE_MS), vibes_double_pulse())
+#define vibes_enqueue_custom_pattern(pattern) \
+    (ENERGY_COUNT(vibe_ms, energy_vibe_pattern_ms(pattern)), vibes_enqueue_custom_pattern(pattern))
+
+#else
+
+#define ENERGY_COUNT(field, n) ((void)0)
+
+static inline void energy_reset(void) {}
+static inline void energy_dump(const char *label) {}
+
+#endif
@@ -0,0 +1,318 @@
+#include "icon_cache.h"
+
+// Icons and UI glyphs are sprites in one atlas resource per platform, packed at build
+// time by tools/icon_atlas.py. The atlas is split into pages of a few sprites each,
+// stored in the watch's own pixel format, so a page is copied straight from flash into
+// a blank bitmap with no PNG to decode. Sprites are handed out as sub-bitmap views of
+// their page.
+//
+// Pages are cached up to a byte budget and the least recently used one is evicted
+// first, along with its views. Pages with a sprite shown in a BitmapLayer are pinned,
+// since the layer keeps drawing from the bitmap, and so are those of the menu rows on
+// screen; pinned pages are never evicted.
+
+#define ICON_ATLAS_MAGIC        "TIA1"
+
+// The header and the sprite table count sprites and pages in a byte
+_Static_assert(SPRITE_COUNT <= UINT8_MAX, "Too many sprites in resources/icons.json for the atlas");
+_Static_assert(ICON_ATLAS_PAGES <= UINT8_MAX, "Atlas page index does not fit a byte");
+
+typedef struct __attribute__((__packed__))
+{
+    char magic[4];
+    uint8_t num_sprites;
+    uint8_t num_pages;
+    uint16_t reserved;
+} AtlasHeader;
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t offset;        // Of the pixel data from the start of the resource
+    uint16_t bytes_per_row;
+    uint8_t w;
+    uint8_t h;
+    uint8_t format;         // GBitmapFormat
+    uint8_t num_colors;     // Palette entries used, 0 for formats without a palette
+    uint8_t palette[16];    // GColor8
+} AtlasPage;
+
+typedef struct __attribute__((__packed__))
+{
+    uint8_t page;
+    uint8_t x;
+    uint8_t y;
+    uint8_t w;
+    uint8_t h;
+} AtlasSprite;
+
+typedef struct
+{
+    GBitmap *bmp;
+    uint32_t lastUsed;  // s_icon_clock at the last lookup of one of its sprites
+    uint16_t bytes;     // Pixels, palette and the views of its sprites
+    uint8_t pins;       // BitmapLayers showing one of its sprites
+} IconCachePage;
+
+static ResHandle s_atlas;
+static AtlasSprite s_atlas_sprites[SPRITE_COUNT];
+static IconCachePage s_pages[ICON_ATLAS_PAGES];
+static GBitmap *s_views[SPRITE_COUNT];
+static int s_num_sprites = 0;
+static int s_num_pages = 0;
+
+static uint32_t s_icon_clock = 0;
+static size_t s_icon_cache_bytes = 0;
+static uint32_t s_icon_cache_hits = 0, s_icon_cache_misses = 0;
+static uint32_t s_icon_cache_loads = 0, s_icon_cache_evictions = 0;
+
+// Drop the least recently used page that is neither pinned nor keep; false if none
+static bool timer_icon_cache_evict(int keep)
+{
+    int victim = -1;
+
+    for (int i = 0; i < s_num_pages; i++)
+    {
+        IconCachePage *page = &s_pages[i];
+
+        if (page->bmp && !page->pins && i != keep &&
+            (victim < 0 || page->lastUsed < s_pages[victim].lastUsed))
+        {
+            victim = i;
+        }
+    }
+
+    if (victim < 0)
+    {
+        return false;
+    }
+
+    // views first, they point into the page
+    for (int i = 0; i < s_num_sprites; i++)
+    {
+        if (s_views[i] && s_atlas_sprites[i].page == victim)
+        {
+            gbitmap_destroy(s_views[i]);
+            s_views[i] = NULL;
+        }
+    }
+
+    gbitmap_destroy(s_pages[victim].bmp);
+    s_pages[victim].bmp = NULL;
+    s_icon_cache_bytes -= s_pages[victim].bytes;
+    s_pages[victim].bytes = 0;
+    s_icon_cache_evictions++;
+    return true;
+}
+
+static GBitmap *timer_icon_page_create(const AtlasPage *info)
+{
+    GSize size = GSize(info->w, info->h);
+
+#ifdef PBL_COLOR
+    if (info->num_colors > 0)
+    {
+        GColor *palette = malloc(info->num_colors * sizeof(GColor));
+
+        if (!palette)
+        {
+            return NULL;
+        }
+
+        memcpy(palette, info->palette, info->num_colors * sizeof(GColor));
+        GBitmap *bmp = gbitmap_create_blank_with_palette(size, info->format, palette, true);
+
+        if (!bmp)
+        {
+            free(palette);
+        }
+
+        return bmp;
+    }
+#endif
+
+    return gbitmap_create_blank(size, info->format);
+}
+
+static bool timer_icon_page_load(int pageIdx)
+{
+    AtlasPage info;
+    uint32_t offset = sizeof(AtlasHeader) + pageIdx * sizeof(AtlasPage);
+
+    if (resource_load_byte_range(s_atlas, offset, (uint8_t *)&info, sizeof(info)) != sizeof(info))
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ timer_icon_page_load(%d) bad atlas", pageIdx);
+        return false;
+    }
+
+    GBitmap *bmp = timer_icon_page_create(&info);
+
+    while (!bmp && timer_icon_cache_evict(pageIdx))
+    {
+        bmp = timer_icon_page_create(&info);
+    }
+
+    if (!bmp)
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ timer_icon_page_load(%d) no memory", pageIdx);
+        return false;
+    }
+
+    uint8_t *data = gbitmap_get_data(bmp);
+    uint16_t stride = gbitmap_get_bytes_per_row(bmp);
+
+    if (stride == info.bytes_per_row)
+    {
+        resource_load_byte_range(s_atlas, info.offset, data, stride * info.h);
+    }
+    else
+    {
+        // the firmware pads rows differently than the atlas; copy row by row
+        uint16_t len = stride < info.bytes_per_row ? stride : info.bytes_per_row;
+
+        for (int y = 0; y < info.h; y++)
+        {
+            resource_load_byte_range(s_atlas, info.offset + y * info.bytes_per_row, data + y * stride, len);
+        }
+    }
+
+    IconCachePage *page = &s_pages[pageIdx];
+    page->bmp = bmp;
+    page->bytes = stride * info.h + info.num_colors + ICON_BITMAP_OVERHEAD;
+    s_icon_cache_bytes += page->bytes;
+    s_icon_cache_loads++;
+    return true;
+}
+
+GBitmap *timer_icon_cache_get(int sprite)
+{
+    if (sprite < 0 || sprite >= s_num_sprites)
+    {
+        return NULL;
+    }
+
+    const AtlasSprite *rect = &s_atlas_sprites[sprite];
+    IconCachePage *page = &s_pages[rect->page];
+    page->lastUsed = ++s_icon_clock;
+
+    if (s_views[sprite])
+    {
+        s_icon_cache_hits++;
+        return s_views[sprite];
+    }
+
+    s_icon_cache_misses++;
+
+    if (!page->bmp && !timer_icon_page_load(rect->page))
+    {
+        return NULL;
+    }
+
+    GRect bounds = GRect(rect->x, rect->y, rect->w, rect->h);
+    GBitmap *view = gbitmap_create_as_sub_bitmap(page->bmp, bounds);
+
+    while (!view && timer_icon_cache_evict(rect->page))
+    {
+        view = gbitmap_create_as_sub_bitmap(page->bmp, bounds);
+    }
+
+    if (!view)
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ timer_icon_cache_get(%d) no memory", sprite);
+        return NULL;
+    }
+
+    s_views[sprite] = view;
+    page->bytes += ICON_BITMAP_OVERHEAD;
+    s_icon_cache_bytes += ICON_BITMAP_OVERHEAD;
+
+    while (s_icon_cache_bytes > ICON_CACHE_BUDGET && timer_icon_cache_evict(rect->page))
+    {
+    }
+
+    return view;
+}
+
+void timer_icon_cache_pin(int sprite)
+{
+    if (sprite >= 0 && sprite < s_num_sprites && s_views[sprite])
+    {
+        s_pages[s_atlas_sprites[sprite].page].pins++;
+    }
+}
+
+void timer_icon_cache_unpin(int sprite)
+{
+    if (sprite >= 0 && sprite < s_num_sprites && s_pages[s_atlas_sprites[sprite].page].pins > 0)
+    {
+        s_pages[s_atlas_sprites[sprite].page].pins--;
+    }
+}
+
+IconCacheStats timer_icon_cache_stats(void)
+{
+    return (IconCacheStats){
+        .hits = s_icon_cache_hits,
+        .misses = s_icon_cache_misses,
+        .loads = s_icon_cache_loads,
+        .evictions = s_icon_cache_evictions,
+        .bytes = s_icon_cache_bytes,
+    };
+}
+
+void timer_icon_cache_init(void)
+{
+    memset(s_pages, 0, sizeof(s_pages));
+    memset(s_views, 0, sizeof(s_views));
+    s_num_sprites = s_num_pages = 0;
+    s_icon_cache_bytes = 0;
+    s_icon_cache_hits = s_icon_cache_misses = s_icon_cache_loads = s_icon_cache_evictions = 0;
+
+    AtlasHeader header;
+    s_atlas = resource_get_handle(RESOURCE_ID_ICON_ATLAS);
+
+    if (resource_load_byte_range(s_atlas, 0, (uint8_t *)&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, ICON_ATLAS_MAGIC, sizeof(header.magic)) != 0 ||
+        header.num_sprites != SPRITE_COUNT || header.num_pages > ICON_ATLAS_PAGES)
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ timer_icon_cache_init atlas does not match, no icons");
+        return;
+    }
+
+    uint32_t offset = sizeof(header) + header.num_pages * sizeof(AtlasPage);
+
+    if (resource_load_byte_range(s_atlas, offset, (uint8_t *)s_atlas_sprites, sizeof(s_atlas_sprites)) != sizeof(s_atlas_sprites))
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ timer_icon_cache_init atlas truncated, no icons");
+        return;
+    }
+
+    s_num_sprites = header.num_sprites;
+    s_num_pages = header.num_pages;
+}
+
+void timer_icon_cache_destroy(void)
+{
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_destroy bytes %d hits %d misses %d loads %d evictions %d",
+            (int)s_icon_cache_bytes, (int)s_icon_cache_hits, (int)s_icon_cache_misses,
+            (int)s_icon_cache_loads, (int)s_icon_cache_evictions);
+
+    for (int i = 0; i < s_num_sprites; i++)
+    {
+        if (s_views[i])
+        {
+            gbitmap_destroy(s_views[i]);
+        }
+    }
+
+    for (int i = 0; i < s_num_pages; i++)
+    {
+        if (s_pages[i].bmp)
+        {
+            gbitmap_destroy(s_pages[i].bmp);
+        }
+    }
+
+    memset(s_pages, 0, sizeof(s_pages));
+    memset(s_views, 0, sizeof(s_views));
+    s_icon_cache_bytes = 0;
+}
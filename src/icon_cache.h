@@ -0,0 +1,36 @@
+#pragma once
+
+#include <pebble.h>
+#include "timer_core.h"
+
+// Timer icons and UI glyphs are sprites of one atlas resource, see icon_cache.c.
+// The atlas pages holding them are cached up to a byte budget and the least recently
+// used one is evicted first. Pages with a sprite shown in a BitmapLayer or in a menu
+// row on screen are pinned and never evicted, so a redraw does not reload them.
+#ifdef PBL_PLATFORM_APLITE
+#define ICON_CACHE_BUDGET       2048    // The UI glyphs and about 3 pages of 4 one bit icons
+#else
+#define ICON_CACHE_BUDGET       6144    // The UI glyphs and about 3 pages of 4 palette icons
+#endif
+#define ICON_BITMAP_OVERHEAD    24      // GBitmap bookkeeping per page and per sprite view
+
+// Sprite indices are the timer icons by iconIdx, then SPRITE_RUNNING and the other UI
+// glyphs, all from icon_table.auto.h.
+
+typedef struct
+{
+    uint32_t hits;
+    uint32_t misses;        // Lookups that had to create a sprite view
+    uint32_t loads;         // Atlas pages read from flash
+    uint32_t evictions;
+    size_t bytes;
+} IconCacheStats;
+
+void timer_icon_cache_init(void);
+void timer_icon_cache_destroy(void);
+
+GBitmap *timer_icon_cache_get(int sprite);
+void timer_icon_cache_pin(int sprite);
+void timer_icon_cache_unpin(int sprite);
+
+IconCacheStats timer_icon_cache_stats(void);
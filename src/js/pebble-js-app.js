@@ -1,24 +1,39 @@
 Pebble.addEventListener('ready', function() {
   console.log('PebbleKit JS ready!');
+  timelineReplay();
 });
 
-const COMMAND_ADD_TO_TIMELINE  =       0;
-const COMMAND_REMOVE_FROM_TIMELINE =   1;
+const COMMAND_TIMELINE_BATCH =         2;
+
+// Pin i of a batch is in keys KEY_BATCH_BASE + i * KEY_BATCH_STRIDE + KEY_PIN_*
+const KEY_BATCH_BASE =                 300;
+const KEY_BATCH_STRIDE =               3;
+const KEY_PIN_ID =                     0;
+const KEY_PIN_DEADLINE =               1;  // Epoch seconds, 0 takes the pin off
+const KEY_PIN_TITLE =                  2;
 
 // Listen for when an AppMessage is received
 Pebble.addEventListener('appmessage', function(e) {
     console.log("Received message: " + JSON.stringify(e.payload));
     
-    if (e.payload.KEY_COMMAND == COMMAND_ADD_TO_TIMELINE) {
-        var date = new Date();
-        date.setTime(date.getTime() + e.payload.KEY_TIMELINE_TIME * 1000);
-        
+    if (e.payload.KEY_COMMAND == COMMAND_TIMELINE_BATCH) {
+        for (var i = 0; i < e.payload.KEY_BATCH_COUNT; i++) {
+            var key = KEY_BATCH_BASE + i * KEY_BATCH_STRIDE;
+            updatePin(e.payload[key + KEY_PIN_ID], e.payload[key + KEY_PIN_DEADLINE], e.payload[key + KEY_PIN_TITLE]);
+        }
+    }
+});
+
+// The watch sends the deadline itself, not the time left, so the pin does not move
+// by however long the message took
+function updatePin(id, deadline, title) {
+    if (deadline) {
         var pin = {
-            "id": "pin-" + e.payload.KEY_TIMELINE_ID,
-            "time": date.toISOString(),
+            "id": "pin-" + id,
+            "time": new Date(deadline * 1000).toISOString(),
             "layout": {
                 "type": "genericPin",
-                "title": e.payload.KEY_TIMELINE_TITLE,
+                "title": title,
                 "tinyIcon": "system://images/NOTIFICATION_GENERIC"
             }
         };
@@ -28,9 +43,9 @@ Pebble.addEventListener('appmessage', function(e) {
         insertUserPin(pin, function(responseText) { 
             console.log('Add result: ' + responseText);
         });
-    } else if (e.payload.KEY_COMMAND == COMMAND_REMOVE_FROM_TIMELINE) {
+    } else {
         var pin = {
-            "id": "pin-" + e.payload.KEY_TIMELINE_ID,
+            "id": "pin-" + id,
         };
         
         console.log('Removing pin: ' + JSON.stringify(pin));
@@ -39,41 +54,262 @@ Pebble.addEventListener('appmessage', function(e) {
             console.log('Remove result: ' + responseText);
         });
     }
-});
+}
 
 /******************************* timeline lib *********************************/
 
-// The timeline public URL root
-var API_URL_ROOT = 'https://timeline-api.getpebble.com/';
+// The timeline public URL root. Setting 'timelineApiRoot' in localStorage points the
+// app at a stand-in server instead, e.g. 'http://192.168.1.2:8080/'.
+var API_URL_ROOT = localStorage.getItem('timelineApiRoot') || 'https://timeline-api.getpebble.com/';
+
+// Requests wait this long for more changes to the same pins before going out
+var TIMELINE_DEBOUNCE_MS = 300;
+// Requests on their way at the same time
+var TIMELINE_MAX_REQUESTS = 2;
+// Failed requests are sent again after this long, doubled after each further failure
+var TIMELINE_RETRY_MS = 2000;
+var TIMELINE_RETRY_MAX_MS = 5 * 60 * 1000;
+// Requests the server has not taken yet, kept across launches
+var TIMELINE_STORE_KEY = 'timelineQueue';
+
+var timelinePending = {};       // pin id -> newest { pin, type, callback } not sent yet
+var timelineOrder = [];         // Ids in timelinePending, oldest first
+var timelineActive = {};        // pin id -> true while its request is on its way
+var timelineActiveCount = 0;
+var timelineFlushTimer = null;
+var timelineToken = null;       // Kept for the session once fetched
+var timelineTokenWaiting = null;
+var timelineStore = timelineStoreLoad();    // pin id -> newest { pin, type } not taken yet
+var timelineRetryMs = TIMELINE_RETRY_MS;
+var timelineRetryTimer = null;
+
+function timelineStoreLoad() {
+  try {
+    return JSON.parse(localStorage.getItem(TIMELINE_STORE_KEY)) || {};
+  } catch (e) {
+    console.log('timeline: dropping unreadable queue: ' + e);
+    return {};
+  }
+}
+
+// Only the newest request of each pin is kept; a callback is not
+function timelineStoreSave() {
+  localStorage.setItem(TIMELINE_STORE_KEY, JSON.stringify(timelineStore));
+}
 
 /**
- * Send a request to the Pebble public web timeline API.
- * @param pin The JSON pin to insert. Must contain 'id' field.
- * @param type The type of request, either PUT or DELETE.
- * @param callback The callback to receive the responseText after the request has completed.
+ * Send the stored requests again, those that are not already waiting or on their way.
+ * Called on launch, when a retry is due and when a request gets through after others
+ * failed.
  */
-function timelineRequest(pin, type, callback) {
-  // User or shared?
-  var url = API_URL_ROOT + 'v1/user/pins/' + pin.id;
-
-  // Create XHR
-  var xhr = new XMLHttpRequest();
-  xhr.onload = function () {
-    console.log('timeline: response received: ' + this.responseText);
-    callback(this.responseText);
-  };
-  xhr.open(type, url);
+function timelineReplay() {
+  if (timelineRetryTimer) {
+    clearTimeout(timelineRetryTimer);
+    timelineRetryTimer = null;
+  }
 
-  // Get token
+  for (var id in timelineStore) {
+    if (!timelinePending[id] && !timelineActive[id]) {
+      console.log('timeline: replaying ' + timelineStore[id].type + ' ' + id);
+      timelineEnqueue(timelineStore[id]);
+    }
+  }
+}
+
+/**
+ * Settle a request by the server's answer: taken, to be tried again later, or refused
+ * for good. A request refused for its token is sent once more with a fresh one.
+ * @param op The request.
+ * @param status The HTTP status, 0 if the server could not be reached.
+ * @param retryAfter The Retry-After header in seconds, if any.
+ * @return True if the request was queued again right away.
+ */
+function timelineSettle(op, status, retryAfter) {
+  var id = op.pin.id;
+  var taken = (status >= 200 && status < 300) || (op.type == 'DELETE' && status == 404);
+  var again = status == 0 || status == 429 || status >= 500;
+  var unauthorized = status == 401 || status == 403;
+
+  // the stored copy stays while it is sent again, unless a newer request replaced it
+  if (unauthorized && !op.tokenRetried && timelineStore[id] === op) {
+    console.log('timeline: ' + op.type + ' ' + id + ' refused (' + status + '), retrying with a fresh token');
+    op.tokenRetried = true;
+    timelineEnqueue(op);
+    return true;
+  }
+
+  if (again) {
+    // the stored copy stays, unless a newer request for the pin replaced it meanwhile
+    if (!timelineRetryTimer) {
+      var delay = retryAfter > 0 ? retryAfter * 1000 : timelineRetryMs;
+      console.log('timeline: ' + op.type + ' ' + id + ' failed (' + status + '), retry in ' + delay + ' ms');
+      timelineRetryTimer = setTimeout(timelineReplay, delay);
+      timelineRetryMs = Math.min(timelineRetryMs * 2, TIMELINE_RETRY_MAX_MS);
+    }
+    return false;
+  }
+
+  if (!taken) {
+    console.log('timeline: ' + op.type + ' ' + id + ' refused (' + status + '), dropped');
+  }
+
+  if (timelineStore[id] === op) {
+    delete timelineStore[id];
+    timelineStoreSave();
+  }
+
+  if (taken) {
+    timelineRetryMs = TIMELINE_RETRY_MS;
+    if (timelineRetryTimer) {
+      // the server is back; the failed ones need not wait for their retry
+      timelineReplay();
+    }
+  }
+  return false;
+}
+
+/**
+ * Get the timeline token, asking the phone only the first time.
+ * @param callback Called with the token.
+ * @param errorCallback Called with the error if there is no token.
+ */
+function timelineGetToken(callback, errorCallback) {
+  if (timelineToken) {
+    callback(timelineToken);
+    return;
+  }
+
+  if (timelineTokenWaiting) {
+    timelineTokenWaiting.push({ callback: callback, errorCallback: errorCallback });
+    return;
+  }
+
+  timelineTokenWaiting = [{ callback: callback, errorCallback: errorCallback }];
   Pebble.getTimelineToken(function(token) {
+    var waiting = timelineTokenWaiting;
+    timelineToken = token;
+    timelineTokenWaiting = null;
+    waiting.forEach(function(w) { w.callback(token); });
+  }, function(error) {
+    var waiting = timelineTokenWaiting;
+    console.log('timeline: error getting timeline token: ' + error);
+    timelineTokenWaiting = null;
+    waiting.forEach(function(w) { w.errorCallback(error); });
+  });
+}
+
+/**
+ * Send one request and start the next waiting one when it is done.
+ * @param op The { pin, type, callback } to send.
+ */
+function timelineSend(op) {
+  var id = op.pin.id;
+  var url = API_URL_ROOT + 'v1/user/pins/' + id;
+
+  timelineActive[id] = true;
+  timelineActiveCount++;
+
+  var done = function(status, responseText, retryAfter) {
+    delete timelineActive[id];
+    timelineActiveCount--;
+    // the callback waits for the outcome of the request sent again
+    if (!timelineSettle(op, status, retryAfter) && op.callback) {
+      op.callback(responseText);
+    }
+    // requests that arrived meanwhile are sent when their wait is over
+    if (!timelineFlushTimer) {
+      timelineFlush();
+    }
+  };
+
+  timelineGetToken(function(token) {
+    // Create XHR
+    var xhr = new XMLHttpRequest();
+    xhr.onload = function () {
+      console.log('timeline: response received: ' + this.status + ' ' + this.responseText);
+      // the next request asks for a fresh token, unless one came meanwhile
+      if ((this.status == 401 || this.status == 403) && timelineToken === token) {
+        timelineToken = null;
+      }
+      done(this.status, this.responseText, parseInt(this.getResponseHeader('Retry-After'), 10));
+    };
+    xhr.onerror = function () {
+      console.log('timeline: request failed: ' + op.type + ' ' + id);
+      done(0, null);
+    };
+    xhr.open(op.type, url);
+
     // Add headers
     xhr.setRequestHeader('Content-Type', 'application/json');
     xhr.setRequestHeader('X-User-Token', '' + token);
 
     // Send
-    xhr.send(JSON.stringify(pin));
-    console.log('timeline: request sent.');
-  }, function(error) { console.log('timeline: error getting timeline token: ' + error); });
+    xhr.send(JSON.stringify(op.pin));
+    console.log('timeline: request sent: ' + op.type + ' ' + id);
+  }, function(error) { done(0, null); });
+}
+
+/**
+ * Send the waiting requests, oldest first, as many as may be on their way. A pin
+ * whose previous request has not come back yet waits for it, so the requests of one
+ * pin reach the server in order.
+ */
+function timelineFlush() {
+  timelineFlushTimer = null;
+
+  for (var i = 0; i < timelineOrder.length && timelineActiveCount < TIMELINE_MAX_REQUESTS; ) {
+    var id = timelineOrder[i];
+    if (timelineActive[id]) {
+      i++;
+      continue;
+    }
+
+    var op = timelinePending[id];
+    timelineOrder.splice(i, 1);
+    delete timelinePending[id];
+    timelineSend(op);
+  }
+}
+
+/**
+ * Queue a request to be sent after a short wait. A request for a pin that still has
+ * one waiting replaces it: PUT is an upsert and DELETE removes whatever is there, so
+ * only the newest matters.
+ * @param op The { pin, type, callback } to send.
+ */
+function timelineEnqueue(op) {
+  var id = op.pin.id;
+  var waiting = timelinePending[id];
+  if (waiting) {
+    console.log('timeline: ' + op.type + ' ' + id + ' replaces ' + waiting.type);
+    if (waiting.callback) {
+      waiting.callback('superseded');
+    }
+  } else {
+    timelineOrder.push(id);
+  }
+  timelinePending[id] = op;
+
+  // Counted from the first waiting request, so steady toggling still gets through
+  if (!timelineFlushTimer) {
+    timelineFlushTimer = setTimeout(timelineFlush, TIMELINE_DEBOUNCE_MS);
+  }
+}
+
+/**
+ * Send a request to the Pebble public web timeline API. The request is stored until
+ * the server takes it, so one made offline or refused for the moment is sent again
+ * later, even after the app was closed.
+ * @param pin The JSON pin to insert. Must contain 'id' field.
+ * @param type The type of request, either PUT or DELETE.
+ * @param callback The callback to receive the responseText after the request has completed,
+ *                 'superseded' if a newer request replaced it, or null if it failed.
+ */
+function timelineRequest(pin, type, callback) {
+  var op = { pin: pin, type: type, callback: callback };
+  timelineStore[pin.id] = op;
+  timelineStoreSave();
+  timelineEnqueue(op);
 }
 
 /**
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <pebble.h>
+
+// Screen geometry of the timer list rows and the timer window, one const descriptor
+// per display shape, picked when compiling for each entry of targetPlatforms. The
+// window and row code read the offsets from here instead of branching on the
+// platform, so a new shape is a new entry below.
+//
+// Offsets in the timer window are from the top of the area under the status bar.
+
+typedef struct
+{
+    // Timer list rows
+    bool rowCentred;            // Time, status bitmap and icon centred as a group, for round
+                                // screens; otherwise status at the left, icon at the right
+    int16_t rowStatusX;         // Status bitmap x when not centred
+    int16_t rowIconSize;        // Timer icon, square
+    int16_t rowGap;             // Between the time, the status bitmap and the icon
+    int16_t rowTextY;           // Time text y, above the cell to fit the font's line height
+
+    // Timer window
+    int16_t sideInset;          // Kept clear at the left and right
+    const char *timeFont;
+    int16_t numberH;            // Days, hours and minutes:seconds text height
+    int16_t daysY;
+    int16_t hoursY;
+    int16_t timeY;
+    int16_t labelH;             // "days", "hours", "min", "sec"
+    int16_t daysLabelY;
+    int16_t hoursLabelY;
+    int16_t secondsLabelY;
+    int16_t minutesLabelX;
+    int16_t buttonMargin;       // Up and down button bitmaps from the top and the bottom
+    int16_t iconX;
+    int16_t iconY;
+    int16_t iconLabelX;
+    int16_t iconLabelGap;       // Icon label below the middle of the icon
+
+    // Status bar
+    bool batteryMeter;          // Drawn by the app, where the status bar shows none
+    int16_t batteryX;           // Battery outline, 14x8 with the terminal at its right
+    int16_t batteryY;
+
+    // Delete confirmation window
+    int16_t deleteInsetX;       // "Yes" and "No" in from the right edge
+    int16_t deleteInsetY;       // "Yes" down from the top and "No" up from the bottom
+
+    // Setup menus; 0 keeps the menu's own cell height
+    int16_t setupCellH;
+    int16_t setupIconCellH;
+} PlatformLayout;
+
+#if defined(PBL_PLATFORM_CHALK)
+static const PlatformLayout platform_layout = {
+    .rowCentred = true,
+    .rowStatusX = 0,
+    .rowIconSize = 28,
+    .rowGap = 2,
+    .rowTextY = -4,
+
+    .sideInset = 18,
+    .timeFont = FONT_KEY_LECO_42_NUMBERS,
+    .numberH = 50,
+    .daysY = -10,
+    .hoursY = 40,
+    .timeY = 90,
+    .labelH = 14,
+    .daysLabelY = 36,
+    .hoursLabelY = 86,
+    .secondsLabelY = 136,
+    .minutesLabelX = 20,
+    .buttonMargin = 35,
+    .iconX = -9,
+    .iconY = 50,
+    .iconLabelX = -8,
+    .iconLabelGap = 6,
+
+    .batteryMeter = false,
+    .batteryX = 0,
+    .batteryY = 0,
+
+    .deleteInsetX = 20,
+    .deleteInsetY = 30,
+
+    .setupCellH = 76,
+    .setupIconCellH = 60,
+};
+#else
+// aplite, basalt and diorite: 144x168 rectangle
+static const PlatformLayout platform_layout = {
+    .rowCentred = false,
+    .rowStatusX = 10,
+    .rowIconSize = 28,
+    .rowGap = 2,
+    .rowTextY = -4,
+
+    .sideInset = 0,
+    .timeFont = FONT_KEY_ROBOTO_BOLD_SUBSET_49,
+    .numberH = 50,
+    .daysY = -10,
+    .hoursY = 40,
+    .timeY = 90,
+    .labelH = 14,
+    .daysLabelY = 36,
+    .hoursLabelY = 86,
+    .secondsLabelY = 136,
+    .minutesLabelX = 20,
+    .buttonMargin = 35,
+    .iconX = 1,
+    .iconY = 50,
+    .iconLabelX = 2,
+    .iconLabelGap = 6,
+
+    .batteryMeter = true,
+    .batteryX = 126,
+    .batteryY = 4,
+
+    .deleteInsetX = 0,
+    .deleteInsetY = 0,
+
+    .setupCellH = 0,
+    .setupIconCellH = 0,
+};
+#endif
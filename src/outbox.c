@@ -0,0 +1,466 @@
+#include "outbox.h"
+#include "energy.h"
+
+// AppMessage keys
+#define KEY_COMMAND             200
+#define KEY_BATCH_COUNT         204
+
+// Pin i of a batch is in keys KEY_BATCH_BASE + i * KEY_BATCH_STRIDE + KEY_PIN_*
+#define KEY_BATCH_BASE          300
+#define KEY_BATCH_STRIDE        3
+#define KEY_PIN_ID              0       // uint16
+#define KEY_PIN_DEADLINE        1       // uint32 epoch seconds, 0 takes the pin off
+#define KEY_PIN_TITLE           2       // cstring, only with a deadline
+
+#define COMMAND_TIMELINE_BATCH  2
+
+// Persistent storage keys, next to those of timer_core.c and wakeup_plan.c
+#define KEY_OUTBOX_QUEUE        21      // Ids still to be sent when the app closed
+#define KEY_OUTBOX_PINNED       22      // Ids whose pin may be on the phone
+
+_Static_assert(KEY_BATCH_BASE + OUTBOX_BATCH_LEN * KEY_BATCH_STRIDE < 1000, "batch keys run into the app keys");
+_Static_assert((OUTBOX_QUEUE_LEN + OUTBOX_BATCH_LEN) * sizeof(uint16_t) <= PERSIST_DATA_MAX_LENGTH,
+               "unsent ids do not fit one persist key");
+_Static_assert((OUTBOX_PINNED_LEN + 1) * sizeof(uint16_t) <= PERSIST_DATA_MAX_LENGTH, "pinned ids do not fit one persist key");
+_Static_assert(OUTBOX_BATCH_LEN <= 8, "s_in_flight_adds has a bit per pin of a batch");
+
+static OutboxHandlers s_handlers;
+static uint16_t s_dirty[OUTBOX_QUEUE_LEN];      // Ids whose pin is still to be sent
+static int s_dirty_count = 0;
+static uint16_t s_in_flight[OUTBOX_BATCH_LEN];  // Ids of the batch on its way
+static int s_in_flight_count = 0;
+static uint8_t s_in_flight_adds = 0;    // Bit i set if pin i of the batch has a deadline
+static int s_tries = 0;                 // Failed sends of that batch
+static AppTimer *s_retry_timer = NULL;
+static uint32_t s_retry_ms = OUTBOX_RETRY_MS;
+
+/*
+ APP_MSG_OK(0) All good, operation was successful.
+ APP_MSG_SEND_TIMEOUT(2) The other end did not confirm receiving the sent data with an (n)ack in time.
+ APP_MSG_SEND_REJECTED(4) The other end rejected the sent data, with a "nack" reply.
+ APP_MSG_NOT_CONNECTED(8) The other end was not connected.
+ APP_MSG_APP_NOT_RUNNING(16) The local application was not running.
+ APP_MSG_INVALID_ARGS(32) The function was called with invalid arguments.
+ APP_MSG_BUSY(64) There are pending (in or outbound) messages that need to be processed first before new ones can be received or sent.
+ APP_MSG_BUFFER_OVERFLOW(128) The buffer was too small to contain the incoming message.
+ APP_MSG_ALREADY_RELEASED(512) The resource had already been released.
+ APP_MSG_CALLBACK_ALREADY_REGISTERED(1024) The callback was already registered.
+ APP_MSG_CALLBACK_NOT_REGISTERED(2048) The callback could not be deregistered, because it had not been registered before.
+ APP_MSG_OUT_OF_MEMORY(4096) The system did not have sufficient application memory to perform the requested operation.
+ APP_MSG_CLOSED(8192) App message was closed.
+ APP_MSG_INTERNAL_ERROR(16384) An internal OS error prevented AppMessage from completing an operation.
+ APP_MSG_INVALID_STATE(32768) The function was called while App Message was not in the appropriate state.
+ */
+static char *translate_error(AppMessageResult result)
+{
+    switch (result) {
+        case APP_MSG_OK: return "APP_MSG_OK";
+        case APP_MSG_SEND_TIMEOUT: return "APP_MSG_SEND_TIMEOUT";
+        case APP_MSG_SEND_REJECTED: return "APP_MSG_SEND_REJECTED";
+        case APP_MSG_NOT_CONNECTED: return "APP_MSG_NOT_CONNECTED";
+        case APP_MSG_APP_NOT_RUNNING: return "APP_MSG_APP_NOT_RUNNING";
+        case APP_MSG_INVALID_ARGS: return "APP_MSG_INVALID_ARGS";
+        case APP_MSG_BUSY: return "APP_MSG_BUSY";
+        case APP_MSG_BUFFER_OVERFLOW: return "APP_MSG_BUFFER_OVERFLOW";
+        case APP_MSG_ALREADY_RELEASED: return "APP_MSG_ALREADY_RELEASED";
+        case APP_MSG_CALLBACK_ALREADY_REGISTERED: return "APP_MSG_CALLBACK_ALREADY_REGISTERED";
+        case APP_MSG_CALLBACK_NOT_REGISTERED: return "APP_MSG_CALLBACK_NOT_REGISTERED";
+        case APP_MSG_OUT_OF_MEMORY: return "APP_MSG_OUT_OF_MEMORY";
+        case APP_MSG_CLOSED: return "APP_MSG_CLOSED";
+        case APP_MSG_INTERNAL_ERROR: return "APP_MSG_INTERNAL_ERROR";
+        //case APP_MSG_INVALID_STATE: return "APP_MSG_INVALID_STATE";
+        default: return "UNKNOWN ERROR";
+    }
+}
+
+// ------------------------- Pins on the Phone ------------------
+//
+// The ids whose pin may be on the phone: sent with a deadline and not taken off
+// since. A pin that never got there needs no removal, so a timer started and stopped
+// before its batch goes out sends nothing. Until the list has been read back from
+// the last launch, or once it overflowed, every pin may be on the phone.
+
+typedef struct
+{
+    uint16_t count;
+    uint16_t ids[OUTBOX_PINNED_LEN];
+} OutboxPinned;
+
+static OutboxPinned s_pinned;
+static bool s_pinned_known = false;     // The list was read back from the last launch
+static bool s_pinned_full = false;      // An id did not fit the list
+static bool s_pinned_dirty = false;     // Changed since it was read back
+
+static int outbox_pinned_find(uint16_t id)
+{
+    for (int i = 0; i < s_pinned.count; i++)
+    {
+        if (s_pinned.ids[i] == id)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static bool outbox_may_be_pinned(uint16_t id)
+{
+    return !s_pinned_known || s_pinned_full || outbox_pinned_find(id) >= 0;
+}
+
+static void outbox_pinned_add(uint16_t id)
+{
+    if (outbox_pinned_find(id) >= 0)
+    {
+        return;
+    }
+
+    if (s_pinned.count == OUTBOX_PINNED_LEN)
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ outbox pinned list full at pin %d", id);
+        s_pinned_full = true;
+        return;
+    }
+
+    s_pinned.ids[s_pinned.count++] = id;
+    s_pinned_dirty = true;
+}
+
+static void outbox_pinned_remove(uint16_t id)
+{
+    int i = outbox_pinned_find(id);
+
+    if (i >= 0)
+    {
+        s_pinned.ids[i] = s_pinned.ids[--s_pinned.count];
+        s_pinned_dirty = true;
+    }
+}
+
+// The pins of the batch in flight with a deadline may have arrived
+static void outbox_pinned_add_in_flight(void)
+{
+    for (int i = 0; i < s_in_flight_count; i++)
+    {
+        if (s_in_flight_adds & (1 << i))
+        {
+            outbox_pinned_add(s_in_flight[i]);
+        }
+    }
+}
+
+// An overflowed list is not saved, so the next launch does not trust it either
+static void outbox_pinned_save(void)
+{
+    if (s_pinned_full)
+    {
+        persist_delete(KEY_OUTBOX_PINNED);
+    }
+    else if (s_pinned_dirty || !s_pinned_known)
+    {
+        persist_write_data(KEY_OUTBOX_PINNED, &s_pinned, sizeof(s_pinned.count) + s_pinned.count * sizeof(s_pinned.ids[0]));
+    }
+}
+
+static void outbox_pinned_restore(void)
+{
+    int len = persist_read_data(KEY_OUTBOX_PINNED, &s_pinned, sizeof(s_pinned));
+
+    s_pinned_known = len >= (int)sizeof(s_pinned.count) &&
+                     len == (int)(sizeof(s_pinned.count) + s_pinned.count * sizeof(s_pinned.ids[0]));
+    s_pinned_full = false;
+    s_pinned_dirty = false;
+
+    if (!s_pinned_known)
+    {
+        s_pinned.count = 0;
+    }
+}
+
+// ------------------------- Sending ----------------------------
+
+static void outbox_send_next(void);
+
+static bool outbox_marked(uint16_t id)
+{
+    for (int i = 0; i < s_dirty_count; i++)
+    {
+        if (s_dirty[i] == id)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void outbox_mark(uint16_t id)
+{
+    if (outbox_marked(id))
+    {
+        return;
+    }
+
+    if (s_dirty_count == OUTBOX_QUEUE_LEN)
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ outbox full, pin %d dropped", id);
+        return;
+    }
+
+    s_dirty[s_dirty_count++] = id;
+}
+
+static void outbox_retry_callback(void *data)
+{
+    s_retry_timer = NULL;
+    outbox_send_next();
+}
+
+// The batch in flight failed to go out; try it again later or give up on it
+static void outbox_failed(AppMessageResult reason)
+{
+    int count = s_in_flight_count;
+
+    if (++s_tries >= OUTBOX_MAX_TRIES || (reason != APP_MSG_BUSY && reason != APP_MSG_SEND_TIMEOUT))
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ outbox batch of %d dropped after %d tries. %s",
+                count, s_tries, translate_error(reason));
+        outbox_pinned_add_in_flight();
+        s_in_flight_count = 0;
+        s_tries = 0;
+        s_retry_ms = OUTBOX_RETRY_MS;
+        outbox_send_next();
+        return;
+    }
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ outbox batch of %d retry in %d ms. %s",
+            count, (int)s_retry_ms, translate_error(reason));
+
+    // the retry rebuilds the batch, with any changes made in the meantime
+    for (int i = 0; i < s_in_flight_count; i++)
+    {
+        outbox_mark(s_in_flight[i]);
+    }
+    s_in_flight_count = 0;
+    s_retry_timer = app_timer_register(s_retry_ms, outbox_retry_callback, NULL);
+    s_retry_ms = s_retry_ms * 2 < OUTBOX_RETRY_MAX_MS ? s_retry_ms * 2 : OUTBOX_RETRY_MAX_MS;
+}
+
+typedef struct
+{
+    time_t deadline;        // 0 takes the pin off
+    char title[OUTBOX_TITLE_LEN];
+} OutboxPin;
+
+static void outbox_write_pin(DictionaryIterator *iter, int slot, uint16_t id, const OutboxPin *pin)
+{
+    uint32_t key = KEY_BATCH_BASE + slot * KEY_BATCH_STRIDE;
+
+    dict_write_uint16(iter, key + KEY_PIN_ID, id);
+    dict_write_uint32(iter, key + KEY_PIN_DEADLINE, pin->deadline);
+    if (pin->deadline)
+    {
+        dict_write_cstring(iter, key + KEY_PIN_TITLE, pin->title);
+    }
+}
+
+static void outbox_send_next(void)
+{
+    if (s_in_flight_count || s_retry_timer)
+    {
+        return;
+    }
+
+    // oldest marks first, as many as fit; the removal of a pin that never got to the
+    // phone is left out
+    OutboxPin pins[OUTBOX_BATCH_LEN];
+    int count = 0;
+    int taken = 0;
+
+    s_in_flight_adds = 0;
+
+    while (taken < s_dirty_count && count < OUTBOX_BATCH_LEN)
+    {
+        uint16_t id = s_dirty[taken++];
+        OutboxPin *pin = &pins[count];
+
+        if (!s_handlers.pin(id, &pin->deadline, pin->title, sizeof(pin->title)))
+        {
+            pin->deadline = 0;
+        }
+
+        if (!pin->deadline && !outbox_may_be_pinned(id))
+        {
+            APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ outbox pin %d never sent, not taken off", id);
+            continue;
+        }
+
+        if (pin->deadline)
+        {
+            s_in_flight_adds |= 1 << count;
+        }
+
+        s_in_flight[count++] = id;
+    }
+
+    s_dirty_count -= taken;
+    memmove(s_dirty, s_dirty + taken, s_dirty_count * sizeof(s_dirty[0]));
+    s_in_flight_count = count;
+
+    if (!count)
+    {
+        return;
+    }
+
+    DictionaryIterator *iter;
+    AppMessageResult result = app_message_outbox_begin(&iter);
+
+    if (result == APP_MSG_OK && iter)
+    {
+        dict_write_uint8(iter, KEY_COMMAND, COMMAND_TIMELINE_BATCH);
+        dict_write_uint8(iter, KEY_BATCH_COUNT, count);
+
+        for (int i = 0; i < count; i++)
+        {
+            outbox_write_pin(iter, i, s_in_flight[i], &pins[i]);
+        }
+
+        result = app_message_outbox_send();
+    }
+
+    if (result != APP_MSG_OK)
+    {
+        outbox_failed(result);
+    }
+}
+
+static void outbox_sent_callback(DictionaryIterator *iterator, void *context)
+{
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ outbox batch of %d sent", s_in_flight_count);
+
+    for (int i = 0; i < s_in_flight_count; i++)
+    {
+        if (s_in_flight_adds & (1 << i))
+        {
+            outbox_pinned_add(s_in_flight[i]);
+        }
+        else
+        {
+            outbox_pinned_remove(s_in_flight[i]);
+        }
+    }
+
+    s_in_flight_count = 0;
+    s_tries = 0;
+    s_retry_ms = OUTBOX_RETRY_MS;
+    outbox_send_next();
+}
+
+static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context)
+{
+    outbox_failed(reason);
+}
+
+// ------------------------- Marking ----------------------------
+
+void outbox_timeline_update(uint16_t id)
+{
+    // a timer already marked goes out once, as it is when its batch is built
+    outbox_mark(id);
+    outbox_send_next();
+}
+
+int outbox_pending(void)
+{
+    return s_dirty_count + s_in_flight_count;
+}
+
+// ------------------------- Unsent Pins ------------------------
+//
+// Pins still to be sent when the app closes are saved and go out on the next launch,
+// so a timer stopped or deleted just before closing does not leave its pin behind.
+// The batch in flight is saved too, since whether it arrived is not known.
+
+static void outbox_queue_save(void)
+{
+    uint16_t ids[OUTBOX_BATCH_LEN + OUTBOX_QUEUE_LEN];
+    int count = 0;
+
+    memcpy(ids, s_in_flight, s_in_flight_count * sizeof(ids[0]));
+    count += s_in_flight_count;
+    memcpy(ids + count, s_dirty, s_dirty_count * sizeof(ids[0]));
+    count += s_dirty_count;
+
+    if (count > 0)
+    {
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ outbox %d pins left for the next launch", count);
+        persist_write_data(KEY_OUTBOX_QUEUE, ids, count * sizeof(ids[0]));
+    }
+    else if (persist_exists(KEY_OUTBOX_QUEUE))
+    {
+        persist_delete(KEY_OUTBOX_QUEUE);
+    }
+}
+
+static void outbox_queue_restore(void)
+{
+    uint16_t ids[OUTBOX_BATCH_LEN + OUTBOX_QUEUE_LEN];
+    int len = persist_read_data(KEY_OUTBOX_QUEUE, ids, sizeof(ids));
+
+    for (int i = 0; i < len / (int)sizeof(ids[0]); i++)
+    {
+        outbox_mark(ids[i]);
+    }
+
+    if (len > 0)
+    {
+        persist_delete(KEY_OUTBOX_QUEUE);
+    }
+}
+
+// ------------------------- Lifecycle --------------------------
+
+void outbox_init(OutboxHandlers handlers)
+{
+    s_handlers = handlers;
+    s_dirty_count = 0;
+    s_in_flight_count = 0;
+    s_tries = 0;
+    s_retry_ms = OUTBOX_RETRY_MS;
+
+    // Nothing is received; the outbox holds a full batch, every pin with a title
+    uint32_t pin_size = dict_calc_buffer_size(3, sizeof(uint16_t), sizeof(uint32_t), OUTBOX_TITLE_LEN)
+                        - dict_calc_buffer_size(0);
+    uint32_t inbox_size = dict_calc_buffer_size(1, sizeof(uint8_t));
+    uint32_t outbox_size = dict_calc_buffer_size(2, sizeof(uint8_t), sizeof(uint8_t)) + OUTBOX_BATCH_LEN * pin_size;
+
+    app_message_register_outbox_failed(outbox_failed_callback);
+    app_message_register_outbox_sent(outbox_sent_callback);
+    AppMessageResult result = app_message_open(inbox_size, outbox_size);
+    if (result != APP_MSG_OK) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "outbox_init app_message_open(%d, %d) failed. %s",
+                (int)inbox_size, (int)outbox_size, translate_error(result));
+    }
+
+    outbox_pinned_restore();
+    outbox_queue_restore();
+    outbox_send_next();
+}
+
+void outbox_deinit(void)
+{
+    outbox_pinned_add_in_flight();
+    outbox_pinned_save();
+    outbox_queue_save();
+
+    if (s_retry_timer)
+    {
+        app_timer_cancel(s_retry_timer);
+        s_retry_timer = NULL;
+    }
+
+    app_message_deregister_callbacks();
+    s_dirty_count = 0;
+    s_in_flight_count = 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <pebble.h>
+
+// Timeline pins on the phone, kept in step with the timers. A changed timer is only
+// marked here; the pins of all marked timers go out together in one batch message,
+// one message in flight at a time, each pin with its absolute deadline. A timer that
+// changes again before its batch is sent goes out once, as it is by then, and not at
+// all if that takes off a pin the phone never got. A batch that fails because the
+// outbox is busy or the phone did not answer is retried with a growing delay. Pins
+// not sent when the app closes go out on the next launch.
+
+#define OUTBOX_QUEUE_LEN        72      // Pins marked and not sent yet
+#define OUTBOX_BATCH_LEN        8       // Pins per message
+#define OUTBOX_MAX_TRIES        5
+#define OUTBOX_RETRY_MS         250     // First retry delay, doubled on each further try
+#define OUTBOX_RETRY_MAX_MS     8000
+#define OUTBOX_TITLE_LEN        20
+#define OUTBOX_PINNED_LEN       64      // Pins that may be on the phone
+
+typedef struct
+{
+    // Fill in the pin of timer id and return true, or return false if it has none.
+    // Asked when the batch is built, so the pin is as of sending.
+    bool (*pin)(uint16_t id, time_t *deadline, char *title, size_t size);
+} OutboxHandlers;
+
+void outbox_init(OutboxHandlers handlers);
+void outbox_deinit(void);
+
+// The pin of timer id has to be sent again, added or taken off
+void outbox_timeline_update(uint16_t id);
+
+int outbox_pending(void);
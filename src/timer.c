@@ -1,21 +1,11 @@
 #include <pebble.h>
-
-// Persistent storage keys
-#define KEY_NUM_TIMERS              1
-#define KEY_SELECTED_MENU_SECTION   2
-#define KEY_SELECTED_MENU_ROW       3
-#define KEY_SHUTDOWN_TIME           4
-#define KEY_VERSION                 5
-#define KEY_FIRST_TIMER           100
-
-// AppMessage keys
-#define KEY_COMMAND             200
-#define KEY_TIMELINE_ID         201
-#define KEY_TIMELINE_TIME       202
-#define KEY_TIMELINE_TITLE      203
-
-#define COMMAND_ADD_TO_TIMELINE         0
-#define COMMAND_REMOVE_FROM_TIMELINE    1
+#include "timer_core.h"
+#include "timer_view.h"
+#include "icon_cache.h"
+#include "energy.h"
+#include "layout.h"
+#include "outbox.h"
+#include "wakeup_plan.h"
 
 #define BITMAP_W 12
 #define BITMAP_H 12
@@ -28,7 +18,17 @@
 #define SECTION_STOPWATCHES     3
 #define NUM_MENU_SECTIONS       4
 
-#define MAX_TIMERS 10
+#if defined(PBL_PLATFORM_APLITE)
+#define PLATFORM_NAME "aplite"
+#elif defined(PBL_PLATFORM_BASALT)
+#define PLATFORM_NAME "basalt"
+#elif defined(PBL_PLATFORM_CHALK)
+#define PLATFORM_NAME "chalk"
+#elif defined(PBL_PLATFORM_DIORITE)
+#define PLATFORM_NAME "diorite"
+#else
+#define PLATFORM_NAME "unknown"
+#endif
 
 #define NEW_TIMER       -1
 #define NEW_STOPWATCH   -2
@@ -36,23 +36,9 @@
 #define TYPE_TIMER      0
 #define TYPE_STOPWATCH  1
 
-static struct
-{
-    uint32_t total_sec;     // Seconds in timer
-    uint32_t elapsed_sec;   // Seconds elapsed
-    uint32_t alert_sec;     // Alert duration in seconds
-    int iconIdx;            // Index into icon_ arrays
-    int vibeIdx;            // Index into vibe_ arrays
-    int vibeRepeat;
-    bool isRunning;         // True iff timer is running
-    bool isCountingUp;      // Stopwatch if true
-} timers[MAX_TIMERS];
-
 static int cur_timer;
-
 static Window *window = NULL;
 static MenuLayer *s_menu_layer = NULL;
-static int num_timers = 3;
 static StatusBarLayer *s_status_bar, *s_timer_status_bar;
 static Layer *s_battery_layer, *s_timer_battery_layer;
 static Layer *s_indicator_up_layer, *s_indicator_down_layer;
@@ -64,369 +50,97 @@ static const int CompOp = GCompOpSet;
 static const int CompOp = GCompOpAssign;
 #endif
 
-#define TIMER_ICON_ITEMS 52
-#define MAX_TIMER_CACHED_ICONS MAX_TIMERS
-
-static char *timer_icon_labels[TIMER_ICON_ITEMS];
-static int timer_icon_bitmap_resids[TIMER_ICON_ITEMS];
-
-#define MAX_TIMER_CACHED_ICONS MAX_TIMERS
-
-typedef struct
+// Show an icon in a BitmapLayer and keep it pinned while shown. shownIdx holds the
+// icon the layer currently pins, or -1.
+static void timer_icon_layer_set(BitmapLayer *layer, int *shownIdx, int iconIdx)
 {
-    int iconIdx;
-    GBitmap *bmp;
-} TimerIconCacheItem;
-
-static TimerIconCacheItem timer_icon_cache[MAX_TIMER_CACHED_ICONS];
-static int cachedNum = 0;
-
-static GBitmap *timer_icon_cache_get(int iconIdx)
-{
-    //APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_get(%d) cachedNum %d", iconIdx, cachedNum);
-
-    for (int i = 0; i < cachedNum && i < MAX_TIMER_CACHED_ICONS; i++)
-    {
-        if (timer_icon_cache[i].iconIdx == iconIdx)
-        {
-            //APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_get(%d) foundAt:%d", iconIdx, i);
-            return timer_icon_cache[i].bmp;
-        }
-    }
+    GBitmap *bmp = timer_icon_cache_get(iconIdx);
 
-    if (cachedNum < MAX_TIMER_CACHED_ICONS)
+    if (bmp)
     {
-        timer_icon_cache[cachedNum].iconIdx = iconIdx;
-        timer_icon_cache[cachedNum].bmp = gbitmap_create_with_resource(timer_icon_bitmap_resids[iconIdx]);
-        cachedNum++;
-
-        //APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_get(%d) addedAt:%d not full", iconIdx, cachedNum - 1);
-
-        return timer_icon_cache[cachedNum - 1].bmp;
+        timer_icon_cache_pin(iconIdx);
     }
-    else
-    {
-        // cache is full; delete first (FIFO)
-        //APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_get(%d) deletingAt:%d full", iconIdx, 0);
-        gbitmap_destroy(timer_icon_cache[0].bmp);
-        int last = cachedNum - 1;
-
-        for (int i = 0; i < last && i < MAX_TIMER_CACHED_ICONS; i++)
-        {
-            timer_icon_cache[i].iconIdx = timer_icon_cache[i+1].iconIdx;
-            timer_icon_cache[i].bmp = timer_icon_cache[i+1].bmp;
-        }
 
-        timer_icon_cache[last].iconIdx = iconIdx;
-        timer_icon_cache[last].bmp = gbitmap_create_with_resource(timer_icon_bitmap_resids[iconIdx]);
-        //APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_get(%d) addedAt:%d full", iconIdx, last);
-        return timer_icon_cache[last].bmp;
-    }
+    timer_icon_cache_unpin(*shownIdx);
+    *shownIdx = bmp ? iconIdx : -1;
+    bitmap_layer_set_bitmap(layer, bmp);
 }
 
-static void timer_icon_cache_init(void)
+static void timer_icon_layer_clear(BitmapLayer *layer, int *shownIdx)
 {
-    for (int i = 0; i < cachedNum && i < MAX_TIMER_CACHED_ICONS; i++)
-    {
-        timer_icon_cache[i].iconIdx = -1;
-    }
-
-    cachedNum = 0;
-
-    int i = 0;
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_BLANK;
-    timer_icon_labels[i++] = "";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_EGG;
-    timer_icon_labels[i++] = "egg" ;
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_BURGER;
-    timer_icon_labels[i++] = "burger" ;
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_FISH;
-    timer_icon_labels[i++] = "fish" ;
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_MEAT;
-    timer_icon_labels[i++] = "meat" ;
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_POTATO;
-    timer_icon_labels[i++] = "potato" ;
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_VEGGIES;
-    timer_icon_labels[i++] = "veggies" ;
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_STAR;
-    timer_icon_labels[i++] = "favorite";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_CAP;
-    timer_icon_labels[i++] = "cappuccino";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_ESPRESSO_S;
-    timer_icon_labels[i++] = "coffee";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_TEA;
-    timer_icon_labels[i++] = "tea";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_BODOM;
-    timer_icon_labels[i++] = "bodom";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_BREAD;
-    timer_icon_labels[i++] = "bread";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_FOOD;
-    timer_icon_labels[i++] = "food";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_STOVE;
-    timer_icon_labels[i++] = "stove";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_TOAST;
-    timer_icon_labels[i++] = "toast";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_WINE;
-    timer_icon_labels[i++] = "wine";
-
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_CALENDAR;
-    timer_icon_labels[i++] = "calendar";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_CLOCK;
-    timer_icon_labels[i++] = "clock";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_BUSINESS;
-    timer_icon_labels[i++] = "business";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_LAUNDRY;
-    timer_icon_labels[i++] = "laundry";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_LAUNDRY2;
-    timer_icon_labels[i++] = "laundry";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_CAT;
-    timer_icon_labels[i++] = "cat";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_DOG;
-    timer_icon_labels[i++] = "dog";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_PEOPLE;
-    timer_icon_labels[i++] = "people";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_PHONE;
-    timer_icon_labels[i++] = "phone";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_PHONE2;
-    timer_icon_labels[i++] = "phone";
-
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_PILL;
-    timer_icon_labels[i++] = "pill";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_DOCTOR;
-    timer_icon_labels[i++] = "doctor";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_AMBULANCE;
-    timer_icon_labels[i++] = "ambulance";
-
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_AIRPLANE;
-    timer_icon_labels[i++] = "airplane";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_BUS;
-    timer_icon_labels[i++] = "bus";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_TAXI;
-    timer_icon_labels[i++] = "taxi";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_TRAIN;
-    timer_icon_labels[i++] = "train";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_WALK;
-    timer_icon_labels[i++] = "walk";
-
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_LOVE;
-    timer_icon_labels[i++] = "heart";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_ANGER;
-    timer_icon_labels[i++] = "angry";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_SLEEP;
-    timer_icon_labels[i++] = "sleep";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_SMILE;
-    timer_icon_labels[i++] = "smile";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_SURPRISE;
-    timer_icon_labels[i++] = "surprise";
-
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_BRAIN;
-    timer_icon_labels[i++] = "brain";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_CALCULATOR;
-    timer_icon_labels[i++] = "calculator";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_DANGER;
-    timer_icon_labels[i++] = "danger";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_FIRE;
-    timer_icon_labels[i++] = "fire";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_HOLIDAY;
-    timer_icon_labels[i++] = "holiday";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_MUSIC;
-    timer_icon_labels[i++] = "music";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_APPLE;
-    timer_icon_labels[i++] = "apple";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_RASPBERRY;
-    timer_icon_labels[i++] = "raspberry pi";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_PRISONER;
-    timer_icon_labels[i++] = "freedom";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_COFFEEBEAN;
-    timer_icon_labels[i++] = "coffee";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_LAPAVONI;
-    timer_icon_labels[i++] = "lapavoni";
-    timer_icon_bitmap_resids[i] = RESOURCE_ID_IMAGE_CHEMIST;
-    timer_icon_labels[i++] = "laboratory";
-
-    if (i != TIMER_ICON_ITEMS)
-    {
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_init not fully initialized items %d != %d (TIMER_ICON_ITEMS)", i, TIMER_ICON_ITEMS);
-    }
-    else
-    {
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_init initialized items %d", i);
-    }
+    bitmap_layer_set_bitmap(layer, NULL);
+    timer_icon_cache_unpin(*shownIdx);
+    *shownIdx = -1;
 }
 
-static void timer_icon_cache_destroy(void)
+// The UI glyphs are drawn all the time, so they stay pinned until the cache goes
+static GBitmap *timer_glyph_load(int sprite)
 {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_destory cachedNum %d", cachedNum);
-
-    for (int i = 0; i < cachedNum && i < MAX_TIMER_CACHED_ICONS; i++)
-    {
-        //APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_icon_cache_destroy() deletingAt:%d", i);
-        gbitmap_destroy(timer_icon_cache[i].bmp);
-        timer_icon_cache[i].bmp = NULL;
-        timer_icon_cache[i].iconIdx = -1;
-    }
-
-    cachedNum = 0;
-}
-
-/*
- APP_MSG_OK(0) All good, operation was successful.
- APP_MSG_SEND_TIMEOUT(2) The other end did not confirm receiving the sent data with an (n)ack in time.
- APP_MSG_SEND_REJECTED(4) The other end rejected the sent data, with a "nack" reply.
- APP_MSG_NOT_CONNECTED(8) The other end was not connected.
- APP_MSG_APP_NOT_RUNNING(16) The local application was not running.
- APP_MSG_INVALID_ARGS(32) The function was called with invalid arguments.
- APP_MSG_BUSY(64) There are pending (in or outbound) messages that need to be processed first before new ones can be received or sent.
- APP_MSG_BUFFER_OVERFLOW(128) The buffer was too small to contain the incoming message.
- APP_MSG_ALREADY_RELEASED(512) The resource had already been released.
- APP_MSG_CALLBACK_ALREADY_REGISTERED(1024) The callback was already registered.
- APP_MSG_CALLBACK_NOT_REGISTERED(2048) The callback could not be deregistered, because it had not been registered before.
- APP_MSG_OUT_OF_MEMORY(4096) The system did not have sufficient application memory to perform the requested operation.
- APP_MSG_CLOSED(8192) App message was closed.
- APP_MSG_INTERNAL_ERROR(16384) An internal OS error prevented AppMessage from completing an operation.
- APP_MSG_INVALID_STATE(32768) The function was called while App Message was not in the appropriate state.
- */
-char *translate_error(AppMessageResult result)
-{
-    switch (result) {
-        case APP_MSG_OK: return "APP_MSG_OK";
-        case APP_MSG_SEND_TIMEOUT: return "APP_MSG_SEND_TIMEOUT";
-        case APP_MSG_SEND_REJECTED: return "APP_MSG_SEND_REJECTED";
-        case APP_MSG_NOT_CONNECTED: return "APP_MSG_NOT_CONNECTED";
-        case APP_MSG_APP_NOT_RUNNING: return "APP_MSG_APP_NOT_RUNNING";
-        case APP_MSG_INVALID_ARGS: return "APP_MSG_INVALID_ARGS";
-        case APP_MSG_BUSY: return "APP_MSG_BUSY";
-        case APP_MSG_BUFFER_OVERFLOW: return "APP_MSG_BUFFER_OVERFLOW";
-        case APP_MSG_ALREADY_RELEASED: return "APP_MSG_ALREADY_RELEASED";
-        case APP_MSG_CALLBACK_ALREADY_REGISTERED: return "APP_MSG_CALLBACK_ALREADY_REGISTERED";
-        case APP_MSG_CALLBACK_NOT_REGISTERED: return "APP_MSG_CALLBACK_NOT_REGISTERED";
-        case APP_MSG_OUT_OF_MEMORY: return "APP_MSG_OUT_OF_MEMORY";
-        case APP_MSG_CLOSED: return "APP_MSG_CLOSED";
-        case APP_MSG_INTERNAL_ERROR: return "APP_MSG_INTERNAL_ERROR";
-        //case APP_MSG_INVALID_STATE: return "APP_MSG_INVALID_STATE";
-        default: return "UNKNOWN ERROR";
-    }
+    GBitmap *bmp = timer_icon_cache_get(sprite);
+    timer_icon_cache_pin(sprite);
+    return bmp;
 }
 
-static char timeline_title[20];
+// ------------------------- Timeline -------------------------
+
+_Static_assert(MAX_TIMERS <= OUTBOX_QUEUE_LEN, "outbox cannot mark every timer");
+_Static_assert(MAX_TIMERS <= OUTBOX_PINNED_LEN, "outbox cannot track the pin of every timer");
 
-static void addToTimeLine(int idx)
+// Pins are keyed by TimerId, so deleting a timer leaves the pins of the others alone
+static bool timeline_pin(uint16_t id, time_t *deadline, char *title, size_t size)
 {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "addToTimeLine");
+    int timer = timer_from_id(id);
 
-    if (timers[idx].isCountingUp) {
-        return;
+    if (timer < 0 || !timer_is_running(timer) || timer_is_counting_up(timer))
+    {
+        return false;
     }
 
-    DictionaryIterator *iter;
-    AppMessageResult result = app_message_outbox_begin(&iter);
-    if (result == APP_MSG_OK && iter) {
-        dict_write_uint8(iter, KEY_COMMAND, COMMAND_ADD_TO_TIMELINE);
-        dict_write_uint8(iter, KEY_TIMELINE_ID, idx);
-        dict_write_uint32(iter, KEY_TIMELINE_TIME, timers[idx].total_sec - timers[idx].elapsed_sec);
-        snprintf(timeline_title, sizeof(timeline_title), "Multi-Timer+ %s", timer_icon_labels[timers[idx].iconIdx]);
-        dict_write_cstring(iter, KEY_TIMELINE_TITLE, timeline_title);
-        result = app_message_outbox_send();
-        if (result != APP_MSG_OK) {
-            APP_LOG(APP_LOG_LEVEL_ERROR, "addToTimeLine app_message_outbox_send failed. %s", translate_error(result));
-        }
-    } else {
-        APP_LOG(APP_LOG_LEVEL_ERROR, "addToTimeLine app_message_outbox_begin failed. %s", translate_error(result));
-    }
+    *deadline = time(NULL) + timer_remaining_sec(timer);
+    snprintf(title, size, "Multi-Timer+ %s", timer_icon_labels[timer_icon_idx(timer)]);
+    return true;
 }
 
-static void removeFromTimeLine(int idx)
+static void timeline_update(int timer)
 {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "removeFromTimeLine");
-
-    if (timers[idx].isCountingUp) {
+    if (timer_is_counting_up(timer)) {
         return;
     }
 
-    DictionaryIterator *iter;
-    AppMessageResult result = app_message_outbox_begin(&iter);
-    if (result == APP_MSG_OK && iter) {
-        dict_write_uint8(iter, KEY_COMMAND, COMMAND_REMOVE_FROM_TIMELINE);
-        dict_write_uint8(iter, KEY_TIMELINE_ID, idx);
-        result = app_message_outbox_send();
-        if (result != APP_MSG_OK) {
-            APP_LOG(APP_LOG_LEVEL_ERROR, "removeFromTimeLine app_message_outbox_send failed. %s", translate_error(result));
-        }
-    } else {
-        APP_LOG(APP_LOG_LEVEL_ERROR, "removeFromTimeLine app_message_outbox_begin failed. %s", translate_error(result));
-    }
-}
-
-static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context)
-{
-    APP_LOG(APP_LOG_LEVEL_ERROR, "Outbox send failed. %s", translate_error(reason));
+    outbox_timeline_update(timer_id(timer));
 }
 
-static void outbox_sent_callback(DictionaryIterator *iterator, void *context)
+// Pins of every running timer, in as few messages as they fit; those sent before
+// the app last closed may have been lost on the way
+static void timeline_sync(void)
 {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "Outbox send success!");
+    for (int timer = 0; timer < timer_slots; timer++)
+    {
+        if (timer_is_running(timer))
+        {
+            timeline_update(timer);
+        }
+    }
 }
 
-#define TIMER_VIBE_ITEMS 4
-#define TIMER_VIBE_REPEATS 5
-
 static char *timer_vibe_labels[TIMER_VIBE_ITEMS] = { "short+short", "long", "short", "short+long" };
 static char *timer_vibe_repeat_labels[TIMER_VIBE_REPEATS] = { "5", "4", "3", "2", "1" };
 
-#define KEY_TOTAL        0
-#define KEY_ELAPSED      1
-#define KEY_ISRUNNING    2
-#define KEY_ICON         3
-#define KEY_TYPE         4
-#define KEY_VIBE         5
-#define KEY_VIBE_REPEAT  6
-
-#define TimerItemKey(timer, offset) (KEY_FIRST_TIMER + MAX_TIMERS * (offset) + (timer))
-
 static int timerIndex(MenuIndex *cell_index)
 {
-    int row = -1;
-    int index = -1;
+    int list = cell_index->section == SECTION_STOPWATCHES ? TIMER_LIST_STOPWATCHES : TIMER_LIST_TIMERS;
 
-    if (cell_index->section == SECTION_STOPWATCHES)
-    {
-        for (int i = 0; i < num_timers && row < cell_index->row; i++)
-        {
-            if (timers[i].isCountingUp)
-            {
-                row++;
-                index = i;
-            }
-        }
-    }
-    else
-    {
-        for (int i = 0; i < num_timers && row < cell_index->row; i++)
-        {
-            if (!timers[i].isCountingUp)
-            {
-                row++;
-                index = i;
-            }
-        }
-    }
-
-    return index;
+    return timer_list_timer(list, cell_index->row);
 }
 
 static MenuIndex timerMenuIndex(int timerIndex)
 {
-    int row = 0;
-
-    for (int i = 0; i < num_timers && i < timerIndex; i++)
+    if (!timer_is_used(timerIndex))
     {
-        if (timers[i].isCountingUp == timers[timerIndex].isCountingUp)
-        {
-            row++;
-        }
+        return (MenuIndex){ .row = 0, .section = SECTION_NEW_TIMER };
     }
 
-    MenuIndex index = (MenuIndex){ .row = row, .section = timers[timerIndex].isCountingUp ? SECTION_STOPWATCHES : SECTION_TIMERS};
+    MenuIndex index = (MenuIndex){ .row = timer_list_row(timerIndex), .section = timer_is_counting_up(timerIndex) ? SECTION_STOPWATCHES : SECTION_TIMERS};
     return index;
 }
 
@@ -438,22 +152,31 @@ static MenuIndex timerMenuIndex(int timerIndex)
 static Window *delete_window = 0;
 static TextLayer *delete_text_layer = 0, *delete_yes_text_layer = 0, *delete_no_text_layer = 0, *delete_icon_label_text_layer = 0;
 static BitmapLayer *delete_icon_bitmap_layer = 0;
+static int delete_icon_shown = -1;
 static int delete_window_pop_cnt = 0;
 
 static void delete_window_yes_click_handler(ClickRecognizerRef recognizer, void *context)
 {
-    for (int i = cur_timer; i < num_timers - 1; i++)
-    {
-        timers[i] = timers[i+1];
-    }
+    int list = timer_is_counting_up(cur_timer) ? TIMER_LIST_STOPWATCHES : TIMER_LIST_TIMERS;
+    int row = timer_list_row(cur_timer);
+
+    bool pinned = timer_is_running(cur_timer) && !timer_is_counting_up(cur_timer);
+    TimerId id = timer_id(cur_timer);
 
-    num_timers--;
+    // no other timer moves, so only the row of this one goes stale
+    timer_remove(cur_timer);
+    timer_row_invalidate(cur_timer);
 
-    if (cur_timer >= num_timers)
+    if (pinned)
     {
-        cur_timer = num_timers - 1;
+        // the id no longer names a timer, so its pin is taken off
+        outbox_timeline_update(id);
     }
 
+    // select the timer that moved up into the row, or the one above the last row
+    int count = timer_list_count(list);
+    cur_timer = timer_list_timer(list, row < count ? row : count - 1);
+
     for (int i = 0; i < delete_window_pop_cnt; i++)
     {
         window_stack_pop(false);
@@ -485,36 +208,18 @@ static void delete_window_load(Window *window)
     text_layer_set_text_alignment(delete_text_layer, GTextAlignmentCenter);
     text_layer_set_overflow_mode(delete_text_layer, GTextOverflowModeWordWrap);
 
-    static char title[48];
-    uint32_t time = timers[cur_timer].total_sec - timers[cur_timer].elapsed_sec;
-    int days = time / 60 / 60 / 24;
-    int hours = time / 60 / 60 - days * 24;
-    int minutes = time / 60 - days * 24 * 60 - hours * 60;
-    int seconds = time - days * 24 * 60 * 60 - hours * 60 * 60 - minutes * 60;
-
-    if (days > 0)
-    {
-        snprintf(title, sizeof(title), "Delete\n%2d %02d:%02d:%02d?", days, hours, minutes, seconds);
-    }
-    else if (hours > 0)
-    {
-        snprintf(title, sizeof(title), "Delete\n%2d:%02d:%02d?", hours, minutes, seconds);
-    }
-    else
-    {
-        snprintf(title, sizeof(title), "Delete\n%2d:%02d?", minutes, seconds);
-    }
+    static char title[48] = "Delete\n";
+    const size_t prefix = strlen("Delete\n");
+    size_t len = prefix + timer_format_duration(title + prefix, sizeof(title) - prefix - 1,
+                                                timer_remaining_sec(cur_timer), DURATION_CLOCK);
+    title[len] = '?';
+    title[len + 1] = '\0';
 
     text_layer_set_text(delete_text_layer, title);
     layer_add_child(window_layer, text_layer_get_layer(delete_text_layer));
 
-#ifdef PBL_PLATFORM_CHALK
-    const int insetX = 20;
-    const int insetY = 30;
-#else
-    const int insetX = 0;
-    const int insetY = 0;
-#endif
+    const int insetX = platform_layout.deleteInsetX;
+    const int insetY = platform_layout.deleteInsetY;
     delete_yes_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x + bounds.size.w - YES_NO_W - 4 - insetX, bounds.origin.y + insetY}, .size = { YES_NO_W, YES_NO_H } });
     text_layer_set_font(delete_yes_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD));
     text_layer_set_text_alignment(delete_yes_text_layer, GTextAlignmentRight);
@@ -533,13 +238,13 @@ static void delete_window_load(Window *window)
     layer_add_child(window_layer, text_layer_get_layer(delete_no_text_layer));
 
     delete_icon_bitmap_layer = bitmap_layer_create((GRect) { .origin = { bounds.origin.x + 10 + insetX, bounds.origin.y + YES_NO_H * 2 + 60}, .size = { ICON_BITMAP_SIZE, ICON_BITMAP_SIZE } });
-    bitmap_layer_set_bitmap(delete_icon_bitmap_layer, timer_icon_cache_get(timers[cur_timer].iconIdx));
+    timer_icon_layer_set(delete_icon_bitmap_layer, &delete_icon_shown, timer_icon_idx(cur_timer));
     bitmap_layer_set_compositing_mode(delete_icon_bitmap_layer, CompOp);
     bitmap_layer_set_alignment(delete_icon_bitmap_layer, GAlignCenter);
     layer_add_child(window_layer, bitmap_layer_get_layer(delete_icon_bitmap_layer));
 
     delete_icon_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x + insetX + ICON_BITMAP_SIZE + 12, bounds.origin.y + YES_NO_H * 2 + 60}, .size = { bounds.size.w, 28 } });
-    text_layer_set_text(delete_icon_label_text_layer, timer_icon_labels[timers[cur_timer].iconIdx]);
+    text_layer_set_text(delete_icon_label_text_layer, timer_icon_labels[timer_icon_idx(cur_timer)]);
     text_layer_set_font(delete_icon_label_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24));
     text_layer_set_text_alignment(delete_icon_label_text_layer, GTextAlignmentLeft);
     text_layer_set_background_color(delete_icon_label_text_layer, GColorClear);
@@ -552,6 +257,7 @@ static void delete_window_unload(Window *window)
     text_layer_destroy(delete_yes_text_layer);
     text_layer_destroy(delete_no_text_layer);
     text_layer_destroy(delete_icon_label_text_layer);
+    timer_icon_layer_clear(delete_icon_bitmap_layer, &delete_icon_shown);
     bitmap_layer_destroy(delete_icon_bitmap_layer);
     window_destroy(delete_window);
 }
@@ -597,13 +303,12 @@ static TextLayer *hours_text_layer = 0, *hours_label_text_layer = 0;
 static TextLayer *time_text_layer = 0;
 static TextLayer *minutes_label_text_layer = 0, *seconds_label_text_layer = 0, *icon_label_text_layer = 0;
 static BitmapLayer *up_bitmap_layer = 0, *select_bitmap_layer = 0, *down_bitmap_layer = 0, *icon_bitmap_layer = 0;
+static int icon_shown = -1;
 static GBitmap *setup_bitmap = 0, *start_bitmap = 0, *pause_bitmap = 0, *reset_bitmap = 0, *running_bitmap = 0, *trash_bitmap = 0, *stopwatch_bitmap = 0, *vibe_bitmap = 0;
 
-static void timer_stop(int timer_num)
+// Show the start button again when the timer on screen stopped
+static void timer_window_stopped(int timer_num)
 {
-    //tick_timer_service_unsubscribe();
-    timers[timer_num].isRunning = false;
-
     if (timer_num == cur_timer)
     {
         bitmap_layer_set_bitmap(select_bitmap_layer, start_bitmap);
@@ -612,146 +317,198 @@ static void timer_stop(int timer_num)
     }
 }
 
-static void vibe(int timer)
+static void timer_update_time(void)
 {
-    switch (timers[timer].vibeIdx) {
-        case 0:
-            vibes_double_pulse();
-            break;
+    static TimerTimeText text;
 
-        case 1:
-            vibes_long_pulse();
-            break;
+    if (!timer_is_used(cur_timer))
+    {
+        return;
+    }
 
-        case 2:
-            vibes_short_pulse();
-            break;
+    timer_time_text(cur_timer, &text);
 
-        case 3:
-        {
-            // Vibe pattern: {on, off, on, ...}
-            static const uint32_t segments[] = { 200, 100, 400 };
-            VibePattern pat = {
-                .durations = segments,
-                .num_segments = ARRAY_LENGTH(segments),
-            };
-            vibes_enqueue_custom_pattern(pat);
-            break;
-        }
-        default:
-            vibes_double_pulse();
-            break;
+    layer_set_hidden((Layer *)days_text_layer, !text.show_days);
+    layer_set_hidden((Layer *)days_label_text_layer, !text.show_days);
+    layer_set_hidden((Layer *)hours_text_layer, !text.show_hours);
+    layer_set_hidden((Layer *)hours_label_text_layer, !text.show_hours);
+
+    if (text.show_days)
+    {
+        text_layer_set_text(days_text_layer, text.days);
+    }
+
+    if (text.show_hours)
+    {
+        text_layer_set_text(hours_text_layer, text.hours);
     }
+
+    text_layer_set_text(time_text_layer, text.time);
 }
 
-static void timer_update_time(void)
+// ------------------------- Menu Rows --------------------------
+//
+// The rows themselves are rendered and cached by timer_view.c; this is what it needs
+// to know of the MenuLayer.
+
+static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer, uint16_t section_index, void *data);
+static int16_t menu_get_cell_height(MenuLayer *menu_layer, MenuIndex *cell_index, void *data);
+
+// True if the row of the timer intersects the visible part of the menu
+static bool menu_row_visible(int index)
 {
-    static char days_title[] = "ddddddd d";
-    static char hours_title[10];
-    static char time_title[20];
-    int alert_timer = -1;
+    MenuIndex row = timerMenuIndex(index);
+    int y = 0;
 
-    for (int i = 0; i < MAX_TIMERS; i++)
+    for (MenuIndex i = { .section = 0, .row = 0 }; i.section < row.section; i.section++)
     {
-        int32_t time_delta = 0;
-
-        if (timers[i].isCountingUp)
+        for (i.row = 0; i.row < menu_get_num_rows_callback(s_menu_layer, i.section, NULL); i.row++)
         {
-            time_delta = timers[i].elapsed_sec;
-        }
-        else
-        {
-            time_delta = timers[i].total_sec - timers[i].elapsed_sec;
+            y += menu_get_cell_height(s_menu_layer, &i, NULL);
         }
+    }
 
-        if (i == cur_timer)
-        {
-            uint32_t time = time_delta;
+    for (MenuIndex i = { .section = row.section, .row = 0 }; i.row < row.row; i.row++)
+    {
+        y += menu_get_cell_height(s_menu_layer, &i, NULL);
+    }
 
-            int days = time / 60 / 60 / 24;
-            int hours = time / 60 / 60 - days * 24;
-            int minutes = time / 60 - days * 24 * 60 - hours * 60;
-            int seconds = time - days * 24 * 60 * 60 - hours * 60 * 60 - minutes * 60;
+    int top = -scroll_layer_get_content_offset(menu_layer_get_scroll_layer(s_menu_layer)).y;
+    int height = layer_get_frame(menu_layer_get_layer(s_menu_layer)).size.h;
 
-            if (days > 0)
-            {
-                snprintf(days_title, sizeof(days_title), "%d", days);
-                layer_set_hidden((Layer *)days_text_layer, false);
-                layer_set_hidden((Layer *)days_label_text_layer, false);
-                text_layer_set_text(days_text_layer, days_title);
-            }
-            else
-            {
-                layer_set_hidden((Layer *)days_text_layer, true);
-                layer_set_hidden((Layer *)days_label_text_layer, true);
-            }
+    return y + menu_get_cell_height(s_menu_layer, &row, NULL) > top && y < top + height;
+}
 
-            if (hours > 0 || days > 0)
-            {
-                snprintf(hours_title, sizeof(hours_title), "%02d", hours);
-                layer_set_hidden((Layer *)hours_text_layer, false);
-                layer_set_hidden((Layer *)hours_label_text_layer, false);
-                text_layer_set_text(hours_text_layer, hours_title);
-            }
-            else
-            {
-                layer_set_hidden((Layer *)hours_text_layer, true);
-                layer_set_hidden((Layer *)hours_label_text_layer, true);
-            }
+// A row on screen changed on a tick
+static void menu_rows_changed(void)
+{
+    layer_mark_dirty(menu_layer_get_layer(s_menu_layer));
+}
 
-            snprintf(time_title, sizeof(time_title), "%02d:%02d", minutes, seconds);
+static GBitmap *menu_row_status_bitmap(const TimerRow *row)
+{
+    switch (row->status)
+    {
+        case TIMER_ROW_RUNNING:
+            return start_bitmap;
 
-            text_layer_set_text(time_text_layer, time_title);
-        }
+        case TIMER_ROW_PAUSED:
+            return pause_bitmap;
 
-        if (!timers[i].isCountingUp)
-        {
-            if (timers[i].isRunning && time_delta <= 0)
-            {
-                timers[i].elapsed_sec = 0;
-                timers[i].alert_sec = 5 - timers[i].vibeRepeat; // vibe repeat
-                timer_stop(i);
-                vibe(i);
-                menu_layer_set_selected_index(s_menu_layer, timerMenuIndex(i), MenuRowAlignCenter, false);
-                timer_update_time();
-            }
-            else if (timers[i].alert_sec > 0)
-            {
-                timers[i].alert_sec--;
-                alert_timer = i;
-            }
-        }
+        case TIMER_ROW_ALERT:
+            return running_bitmap;
+
+        default:
+            return NULL;
     }
+}
 
-    if (alert_timer >= 0)
+// ------------------------- Menu Row Layout --------------------
+//
+// The row font and the text sizes a timer row and the add rows are laid out with.
+// Measuring text walks the font's glyphs, so it is done once per cell size and kept,
+// rather than on every row draw.
+
+#define ROW_LAYOUT_SLOTS    2
+#define ROW_TIME_WIDEST     "999:00:00"
+
+enum
+{
+    ROW_ADD_TIMER,
+    ROW_ADD_STOPWATCH,
+    ROW_ADD_MAX,
+    ROW_ADD_ITEMS
+};
+
+static const char *const row_add_labels[ROW_ADD_ITEMS] = { "+ Timer", "+ Stopwatch", "Max Timers" };
+
+typedef struct
+{
+    GSize cell;                     // Cell size laid out for, zero if the slot is unused
+    GRect add[ROW_ADD_ITEMS];       // row_add_labels, centred
+    GRect status[2];                // Timer row parts, by status bitmap: 12 or 28 pixels
+    GRect icon[2];
+    GRect text[2];
+} MenuRowLayout;
+
+static GFont s_row_font;
+static MenuRowLayout s_row_layouts[ROW_LAYOUT_SLOTS];
+static int s_row_layout_next = 0;   // Slot replaced on a miss
+
+static void menu_row_layout_init(void)
+{
+    s_row_font = fonts_get_system_font(FONT_KEY_GOTHIC_28);
+    memset(s_row_layouts, 0, sizeof(s_row_layouts));
+    s_row_layout_next = 0;
+}
+
+static void menu_row_layout_timer(MenuRowLayout *layout, int big, GSize cell, GSize time)
+{
+    const PlatformLayout *pl = &platform_layout;
+    const int statusSize = big ? 28 : 12;
+    const int iconSize = pl->rowIconSize;
+    GRect *status = &layout->status[big], *icon = &layout->icon[big], *text = &layout->text[big];
+
+    if (pl->rowCentred)
     {
-        vibe(alert_timer);
+        // time, status and icon side by side in the middle of the cell
+        const int rightPad = (cell.w - time.w - iconSize - statusSize - 2 * pl->rowGap) / 2;
+        *icon = GRect(cell.w - iconSize - rightPad, (cell.h - iconSize) / 2, iconSize, iconSize);
+        *status = GRect(icon->origin.x - statusSize - pl->rowGap, (cell.h - statusSize) / 2, statusSize, statusSize);
+        *text = GRect(0, pl->rowTextY, cell.w - statusSize - iconSize - rightPad - pl->rowGap, time.h);
+    }
+    else
+    {
+        // status at the left, icon at the right and the time right aligned before it
+        *icon = GRect(cell.w - iconSize - pl->rowGap, (cell.h - iconSize) / 2, iconSize, iconSize);
+        *status = GRect(pl->rowStatusX, (cell.h - statusSize) / 2, statusSize, statusSize);
+        *text = GRect(iconSize, pl->rowTextY, cell.w - 2 * iconSize - pl->rowGap, time.h);
     }
 }
 
-static void timer_handle_tick(struct tm* tick_time, TimeUnits units_changed)
+static const MenuRowLayout *menu_row_layout(GRect frame)
 {
-    bool isRunning = false;
-
-    for (int i = 0; i < MAX_TIMERS; i++)
+    for (int i = 0; i < ROW_LAYOUT_SLOTS; i++)
     {
-        if (timers[i].isRunning)
-        {
-            timers[i].elapsed_sec++;
-            isRunning = true;
-        }
-        else if (timers[i].alert_sec > 0)
+        if (s_row_layouts[i].cell.w == frame.size.w && s_row_layouts[i].cell.h == frame.size.h)
         {
-            isRunning = true;
+            return &s_row_layouts[i];
         }
     }
 
-    timer_update_time();
+    MenuRowLayout *layout = &s_row_layouts[s_row_layout_next];
+    s_row_layout_next = (s_row_layout_next + 1) % ROW_LAYOUT_SLOTS;
+    layout->cell = frame.size;
 
-    if (isRunning)
+    for (int i = 0; i < ROW_ADD_ITEMS; i++)
     {
-        layer_mark_dirty(menu_layer_get_layer(s_menu_layer));
+        GSize size = graphics_text_layout_get_content_size(row_add_labels[i], s_row_font, frame, GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter);
+        layout->add[i] = GRect((frame.size.w - size.w) / 2, platform_layout.rowTextY, size.w, size.h);
     }
+
+    GSize time = graphics_text_layout_get_content_size(ROW_TIME_WIDEST, s_row_font, frame, GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft);
+    menu_row_layout_timer(layout, 0, frame.size, time);
+    menu_row_layout_timer(layout, 1, frame.size, time);
+    return layout;
+}
+
+static void timer_expired(int timer)
+{
+    timer_row_invalidate(timer);
+    timer_window_stopped(timer);
+    menu_layer_set_selected_index(s_menu_layer, timerMenuIndex(timer), MenuRowAlignCenter, false);
+}
+
+static void timer_alerted(int timer)
+{
+    timer_row_invalidate(timer);
+}
+
+static void timer_fired(void)
+{
+    layer_mark_dirty(menu_layer_get_layer(s_menu_layer));
+    timer_update_time();
+    timer_view_schedule();
 }
 
 
@@ -773,9 +530,8 @@ static void number_window_selected(NumberWindow *this_window, void *context)
 {
     int mode = (int)context;
     number_window_value[mode] = number_window_get_value(this_window);
-    timers[cur_timer].total_sec = number_window_value[NUM_WIN_MODE_DAYS] * 24 * 60 * 60 + number_window_value[NUM_WIN_MODE_HOURS] * 60 * 60 +
-    number_window_value[NUM_WIN_MODE_MINUTES] * 60 + number_window_value[NUM_WIN_MODE_SECONDS];
-    timers[cur_timer].elapsed_sec = 0;
+    timer_set_total_sec(cur_timer, number_window_value[NUM_WIN_MODE_DAYS] * 24 * 60 * 60 + number_window_value[NUM_WIN_MODE_HOURS] * 60 * 60 +
+    number_window_value[NUM_WIN_MODE_MINUTES] * 60 + number_window_value[NUM_WIN_MODE_SECONDS]);
     timer_update_time();
     mode++;
 
@@ -828,11 +584,11 @@ static void number_window_init(void)
     for (int i = 0; i < NUM_WIN_MODE_DONE; i++)
         number_window[i] = NULL;
 
-    uint32_t time = timers[cur_timer].total_sec - timers[cur_timer].elapsed_sec;
-    int days = number_window_value[NUM_WIN_MODE_DAYS] = time / 60 / 60 / 24;
-    int hours = number_window_value[NUM_WIN_MODE_HOURS] = time / 60 / 60 - days * 24;
-    int minutes = number_window_value[NUM_WIN_MODE_MINUTES] = time / 60 - days * 24 * 60 - hours * 60;
-    number_window_value[NUM_WIN_MODE_SECONDS] = time - days * 24 * 60 * 60 - hours * 60 * 60 - minutes * 60;
+    TimerDuration d = timer_duration(timer_remaining_sec(cur_timer));
+    number_window_value[NUM_WIN_MODE_DAYS] = d.days;
+    number_window_value[NUM_WIN_MODE_HOURS] = d.hours;
+    number_window_value[NUM_WIN_MODE_MINUTES] = d.minutes;
+    number_window_value[NUM_WIN_MODE_SECONDS] = d.seconds;
 
     number_window_build(NUM_WIN_MODE_DAYS);
 }
@@ -855,12 +611,10 @@ static uint16_t setup_icon_menu_get_num_rows_callback(MenuLayer *menu_layer, uin
     return TIMER_ICON_ITEMS;
 }
 
-#ifdef PBL_PLATFORM_CHALK
 static int16_t setup_icon_menu_get_cell_height(MenuLayer *menu_layer, MenuIndex *cell_index, void *data)
 {
-    return 60;
+    return platform_layout.setupIconCellH;
 }
-#endif
 
 static void setup_icon_menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuIndex *cell_index, void *data)
 {
@@ -869,7 +623,8 @@ static void setup_icon_menu_draw_row_callback(GContext* ctx, const Layer *cell_l
 
 void setup_icon_menu_select_click_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data)
 {
-    timers[cur_timer].iconIdx = cell_index->row;
+    timer_set_icon_idx(cur_timer, cell_index->row);
+    store_mark_dirty(cur_timer);
 
     window_stack_pop(true);
 }
@@ -885,13 +640,11 @@ static void setup_icon_window_load(Window *window)
         .get_num_rows = setup_icon_menu_get_num_rows_callback,
         .draw_row = setup_icon_menu_draw_row_callback,
         .select_click = setup_icon_menu_select_click_callback,
-#ifdef PBL_PLATFORM_CHALK
-        .get_cell_height = setup_icon_menu_get_cell_height,
-#endif
+        .get_cell_height = platform_layout.setupIconCellH ? setup_icon_menu_get_cell_height : NULL,
     });
 
     menu_layer_set_click_config_onto_window(setup_icon_menu_layer, window);
-    MenuIndex index = (MenuIndex){ .row = timers[cur_timer].iconIdx, .section = 0};
+    MenuIndex index = (MenuIndex){ .row = timer_icon_idx(cur_timer), .section = 0};
     menu_layer_set_selected_index(setup_icon_menu_layer, index, MenuRowAlignCenter, false);
 #ifdef PBL_COLOR
     menu_layer_set_highlight_colors(setup_icon_menu_layer, GColorVividCerulean, GColorBlack);
@@ -910,8 +663,8 @@ static void setup_icon_window_unload(Window *window)
     menu_layer_destroy(setup_icon_menu_layer);
     layer_destroy(s_setup_icon_indicator_up_layer);
     layer_destroy(s_setup_icon_indicator_down_layer);
-    bitmap_layer_set_bitmap(icon_bitmap_layer, timer_icon_cache_get(timers[cur_timer].iconIdx));
-    text_layer_set_text(icon_label_text_layer, timer_icon_labels[timers[cur_timer].iconIdx]);
+    timer_icon_layer_set(icon_bitmap_layer, &icon_shown, timer_icon_idx(cur_timer));
+    text_layer_set_text(icon_label_text_layer, timer_icon_labels[timer_icon_idx(cur_timer)]);
     window_destroy(setup_icon_window);
 }
 
@@ -941,7 +694,8 @@ static void setup_vibe_menu_draw_row_callback(GContext* ctx, const Layer *cell_l
 
 static void setup_vibe_menu_select_click_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data)
 {
-    timers[cur_timer].vibeIdx = cell_index->row;
+    timer_set_vibe_idx(cur_timer, cell_index->row);
+    store_mark_dirty(cur_timer);
     window_stack_pop(true);
 }
 
@@ -960,7 +714,7 @@ static void setup_vibe_window_load(Window *window)
     });
 
     menu_layer_set_click_config_onto_window(setup_vibe_menu_layer, window);
-    MenuIndex index = (MenuIndex){ .row = timers[cur_timer].vibeIdx, .section = 0};
+    MenuIndex index = (MenuIndex){ .row = timer_vibe_idx(cur_timer), .section = 0};
     menu_layer_set_selected_index(setup_vibe_menu_layer, index, MenuRowAlignCenter, false);
 #ifdef PBL_COLOR
     menu_layer_set_highlight_colors(setup_vibe_menu_layer, GColorVividCerulean, GColorBlack);
@@ -1009,7 +763,8 @@ static void setup_vibe_repeat_menu_draw_row_callback(GContext* ctx, const Layer
 
 void setup_vibe_repeat_menu_select_click_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data)
 {
-    timers[cur_timer].vibeRepeat = cell_index->row;
+    timer_set_vibe_repeat(cur_timer, cell_index->row);
+    store_mark_dirty(cur_timer);
     window_stack_pop(true);
 }
 
@@ -1028,7 +783,7 @@ static void setup_vibe_repeat_window_load(Window *window)
     });
 
     menu_layer_set_click_config_onto_window(setup_vibe_repeat_menu_layer, window);
-    MenuIndex index = (MenuIndex){ .row = timers[cur_timer].vibeRepeat, .section = 0};
+    MenuIndex index = (MenuIndex){ .row = timer_vibe_repeat(cur_timer), .section = 0};
     menu_layer_set_selected_index(setup_vibe_repeat_menu_layer, index, MenuRowAlignCenter, false);
 #ifdef PBL_COLOR
     menu_layer_set_highlight_colors(setup_vibe_repeat_menu_layer, GColorVividCerulean, GColorBlack);
@@ -1068,7 +823,7 @@ static char *setup_menu_labels[2][5]= {
 
 static uint16_t setup_menu_get_num_rows_callback(MenuLayer *menu_layer, uint16_t section_index, void *data)
 {
-    if (timers[cur_timer].isCountingUp)
+    if (timer_is_counting_up(cur_timer))
     {
         return setup_menu_labels_count[SETUP_MEMU_STOPWATCH];
     }
@@ -1078,23 +833,21 @@ static uint16_t setup_menu_get_num_rows_callback(MenuLayer *menu_layer, uint16_t
     }
 }
 
-#ifdef PBL_PLATFORM_CHALK
 static int16_t setup_menu_get_cell_height(MenuLayer *menu_layer, MenuIndex *cell_index, void *data)
 {
-    return 76;
+    return platform_layout.setupCellH;
 }
-#endif
 
 static void setup_menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuIndex *cell_index, void *data)
 {
     static char title[36];
 
-    if (timers[cur_timer].isCountingUp)
+    if (timer_is_counting_up(cur_timer))
     {
         switch (cell_index->row)
         {
             case 0: // Icon
-                menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MEMU_STOPWATCH][cell_index->row], timer_icon_labels[timers[cur_timer].iconIdx], timer_icon_cache_get(timers[cur_timer].iconIdx));
+                menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MEMU_STOPWATCH][cell_index->row], timer_icon_labels[timer_icon_idx(cur_timer)], timer_icon_cache_get(timer_icon_idx(cur_timer)));
                 break;
             case 1: // Delete
                 menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MEMU_STOPWATCH][cell_index->row], NULL, trash_bitmap);
@@ -1107,36 +860,19 @@ static void setup_menu_draw_row_callback(GContext* ctx, const Layer *cell_layer,
         {
             case 0: // Time
             {
-                uint32_t time = timers[cur_timer].total_sec;
-                int days = time / 60 / 60 / 24;
-                int hours = time / 60 / 60 - days * 24;
-                int minutes = time / 60 - days * 24 * 60 - hours * 60;
-                int seconds = time - days * 24 * 60 * 60 - hours * 60 * 60 - minutes * 60;
-
-                if (days > 0)
-                {
-                    snprintf(title, sizeof(title), "%2d %02d:%02d:%02d", days, hours, minutes, seconds);
-                }
-                else if (hours > 0)
-                {
-                    snprintf(title, sizeof(title), "%2d:%02d:%02d", hours, minutes, seconds);
-                }
-                else
-                {
-                    snprintf(title, sizeof(title), "%2d:%02d", minutes, seconds);
-                }
+                timer_format_duration(title, sizeof(title), timers[cur_timer].total_sec, DURATION_CLOCK);
 
                 menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MENU_TIMER][cell_index->row], title, running_bitmap);
                 break;
             }
             case 1: // Icon
-                menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MENU_TIMER][cell_index->row], timer_icon_labels[timers[cur_timer].iconIdx], timer_icon_cache_get(timers[cur_timer].iconIdx));
+                menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MENU_TIMER][cell_index->row], timer_icon_labels[timer_icon_idx(cur_timer)], timer_icon_cache_get(timer_icon_idx(cur_timer)));
                 break;
             case 2:  // Vibe
-                menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MENU_TIMER][cell_index->row], timer_vibe_labels[timers[cur_timer].vibeIdx], vibe_bitmap);
+                menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MENU_TIMER][cell_index->row], timer_vibe_labels[timer_vibe_idx(cur_timer)], vibe_bitmap);
                 break;
             case 3:  // Vibe Repeat
-                menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MENU_TIMER][cell_index->row], timer_vibe_repeat_labels[timers[cur_timer].vibeRepeat], vibe_bitmap);
+                menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MENU_TIMER][cell_index->row], timer_vibe_repeat_labels[timer_vibe_repeat(cur_timer)], vibe_bitmap);
                 break;
             case 4: // Delete
                 menu_cell_basic_draw(ctx, cell_layer, setup_menu_labels[SETUP_MENU_TIMER][cell_index->row], NULL, trash_bitmap);
@@ -1147,7 +883,7 @@ static void setup_menu_draw_row_callback(GContext* ctx, const Layer *cell_layer,
 
 void setup_menu_select_click_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data)
 {
-    if (timers[cur_timer].isCountingUp)
+    if (timer_is_counting_up(cur_timer))
     {
         switch (cell_index->row) {
             case 0: // Icon
@@ -1235,9 +971,7 @@ static void setup_window_load(Window *window)
         .get_num_rows = setup_menu_get_num_rows_callback,
         .draw_row = setup_menu_draw_row_callback,
         .select_click = setup_menu_select_click_callback,
-#ifdef PBL_PLATFORM_CHALK
-        .get_cell_height = setup_menu_get_cell_height,
-#endif
+        .get_cell_height = platform_layout.setupCellH ? setup_menu_get_cell_height : NULL,
     });
 
     menu_layer_set_click_config_onto_window(setup_menu_layer, window);
@@ -1266,7 +1000,7 @@ static void setup_window_unload(Window *window)
 
 static void timer_up_click_handler(ClickRecognizerRef recognizer, void *context)
 {
-    if (!timers[cur_timer].isRunning)
+    if (!timer_is_running(cur_timer))
     {
         setup_window = window_create();
         window_set_window_handlers(setup_window, (WindowHandlers)
@@ -1281,7 +1015,7 @@ static void timer_up_click_handler(ClickRecognizerRef recognizer, void *context)
 
 static void timer_up_long_click_handler(ClickRecognizerRef recognizer, void *context)
 {
-    if (!timers[cur_timer].isRunning)
+    if (!timer_is_running(cur_timer))
     {
         delete_window_pop_cnt = 1;
         delete_window = window_create();
@@ -1296,34 +1030,35 @@ static void timer_up_long_click_handler(ClickRecognizerRef recognizer, void *con
 
 static void timer_down_click_handler(ClickRecognizerRef recognizer, void *context)
 {
-    if (!timers[cur_timer].isRunning)
+    if (!timer_is_running(cur_timer))
     {
-        // timer_reset()
-        timers[cur_timer].elapsed_sec = 0;
+        timer_reset(cur_timer);
         timer_update_time();
     }
 }
 
 static bool timer_toggle(int timer)
 {
-    if (timers[timer].isRunning)
+    timer_row_invalidate(timer);
+    layer_mark_dirty(menu_layer_get_layer(s_menu_layer));
+
+    if (timer_is_running(timer))
     {
         timer_stop(timer);
-        removeFromTimeLine(timer);
+        timer_window_stopped(timer);
+        timeline_update(timer);
+        timer_view_schedule();
         return false;
     }
-    else if (!timers[timer].isCountingUp && timers[timer].total_sec == 0)
+    else if (!timer_start(timer))
     {
         vibes_double_pulse();
-        removeFromTimeLine(timer);
         return false;
     }
     else
     {
-        // timer_start
-        timers[timer].isRunning = true;
-        timers[timer].alert_sec = 0;
-        addToTimeLine(timer);
+        timeline_update(timer);
+        timer_view_schedule();
         return true;
     }
 }
@@ -1348,17 +1083,22 @@ static void timer_click_config_provider(void *context)
 
 static void battery_proc(Layer *layer, GContext *ctx)
 {
-#ifndef PBL_PLATFORM_CHALK
+    if (!platform_layout.batteryMeter)
+    {
+        return;
+    }
+
     // Emulate battery meter on Aplite
+    const int x = platform_layout.batteryX;
+    const int y = platform_layout.batteryY;
     graphics_context_set_stroke_color(ctx, GColorWhite);
-    graphics_draw_rect(ctx, GRect(126, 4, 14, 8));
-    graphics_draw_line(ctx, GPoint(140, 6), GPoint(140, 9));
+    graphics_draw_rect(ctx, GRect(x, y, 14, 8));
+    graphics_draw_line(ctx, GPoint(x + 14, y + 2), GPoint(x + 14, y + 5));
 
     BatteryChargeState state = battery_state_service_peek();
     int width = (int)(float)(((float)state.charge_percent / 100.0F) * 10.0F);
     graphics_context_set_fill_color(ctx, GColorWhite);
-    graphics_fill_rect(ctx, GRect(128, 6, width, 4), 0, GCornerNone);
-#endif
+    graphics_fill_rect(ctx, GRect(x + 2, y + 2, width, 4), 0, GCornerNone);
 }
 
 static void timer_window_load(Window *window)
@@ -1367,102 +1107,92 @@ static void timer_window_load(Window *window)
     Layer *window_layer = window_get_root_layer(window);
     GRect bounds = layer_get_frame(window_layer);
 
-#ifdef PBL_PLATFORM_CHALK
-    bounds.origin.x = 18;
-    bounds.size.w -= 36;
-#endif
+    const PlatformLayout *pl = &platform_layout;
+    bounds.origin.x += pl->sideInset;
+    bounds.size.w -= 2 * pl->sideInset;
     bounds.origin.y += STATUS_BAR_LAYER_HEIGHT;
     bounds.size.h -= STATUS_BAR_LAYER_HEIGHT;
 
-    const char * timeFont =
-#ifdef PBL_PLATFORM_CHALK
-    FONT_KEY_LECO_42_NUMBERS;
-#else
-    FONT_KEY_ROBOTO_BOLD_SUBSET_49;
-#endif
-    ;
-    days_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + -10 }, .size = { bounds.size.w - BITMAP_W - BITMAP_PAD, 50 } });
-    text_layer_set_font(days_text_layer, fonts_get_system_font(timeFont));
+    GFont timeFont = fonts_get_system_font(pl->timeFont);
+    GFont labelFont = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+    const int textW = bounds.size.w - BITMAP_W - BITMAP_PAD;
+    const int buttonX = bounds.origin.x + bounds.size.w - BITMAP_W - 1;
+    days_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + pl->daysY }, .size = { textW, pl->numberH } });
+    text_layer_set_font(days_text_layer, timeFont);
     text_layer_set_text_alignment(days_text_layer, GTextAlignmentRight);
     layer_add_child(window_layer, text_layer_get_layer(days_text_layer));
 
-    hours_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + 40 }, .size = { bounds.size.w - BITMAP_W - BITMAP_PAD, 50 } });
-    text_layer_set_font(hours_text_layer, fonts_get_system_font(timeFont));
+    hours_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + pl->hoursY }, .size = { textW, pl->numberH } });
+    text_layer_set_font(hours_text_layer, timeFont);
     text_layer_set_text_alignment(hours_text_layer, GTextAlignmentRight);
     layer_add_child(window_layer, text_layer_get_layer(hours_text_layer));
 
-    time_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + 90 }, .size = { bounds.size.w - BITMAP_W - BITMAP_PAD, 50 } });
-    text_layer_set_font(time_text_layer, fonts_get_system_font(timeFont));
+    time_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + pl->timeY }, .size = { textW, pl->numberH } });
+    text_layer_set_font(time_text_layer, timeFont);
     text_layer_set_text_alignment(time_text_layer, GTextAlignmentRight);
     layer_add_child(window_layer, text_layer_get_layer(time_text_layer));
 
-    days_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + 36 }, .size = { bounds.size.w - BITMAP_W - BITMAP_PAD, 14 } });
+    days_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + pl->daysLabelY }, .size = { textW, pl->labelH } });
     text_layer_set_text(days_label_text_layer, "days");
-    text_layer_set_font(days_label_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+    text_layer_set_font(days_label_text_layer, labelFont);
     text_layer_set_text_alignment(days_label_text_layer, GTextAlignmentRight);
     text_layer_set_background_color(days_label_text_layer, GColorClear);
     layer_add_child(window_layer, text_layer_get_layer(days_label_text_layer));
 
-    hours_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + 86 }, .size = { bounds.size.w - BITMAP_W - BITMAP_PAD, 14 } });
+    hours_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + pl->hoursLabelY }, .size = { textW, pl->labelH } });
     text_layer_set_text(hours_label_text_layer, "hours");
-    text_layer_set_font(hours_label_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+    text_layer_set_font(hours_label_text_layer, labelFont);
     text_layer_set_text_alignment(hours_label_text_layer, GTextAlignmentRight);
     text_layer_set_background_color(hours_label_text_layer, GColorClear);
     layer_add_child(window_layer, text_layer_get_layer(hours_label_text_layer));
 
-    minutes_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x + 20, bounds.origin.y + 136 }, .size = { bounds.size.w / 4, 14 } });
+    minutes_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x + pl->minutesLabelX, bounds.origin.y + pl->secondsLabelY }, .size = { bounds.size.w / 4, pl->labelH } });
     text_layer_set_text(minutes_label_text_layer, "min");
-    text_layer_set_font(minutes_label_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+    text_layer_set_font(minutes_label_text_layer, labelFont);
     text_layer_set_text_alignment(minutes_label_text_layer, GTextAlignmentRight);
     text_layer_set_background_color(minutes_label_text_layer, GColorClear);
     //layer_add_child(window_layer, text_layer_get_layer(minutes_label_text_layer));
 
-    seconds_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + 136 }, .size = { bounds.size.w - BITMAP_W - BITMAP_PAD, 14 } });
+    seconds_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x, bounds.origin.y + pl->secondsLabelY }, .size = { textW, pl->labelH } });
     text_layer_set_text(seconds_label_text_layer, "sec");
-    text_layer_set_font(seconds_label_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+    text_layer_set_font(seconds_label_text_layer, labelFont);
     text_layer_set_text_alignment(seconds_label_text_layer, GTextAlignmentRight);
     text_layer_set_background_color(seconds_label_text_layer, GColorClear);
     //layer_add_child(window_layer, text_layer_get_layer(seconds_label_text_layer));
 
-    up_bitmap_layer = bitmap_layer_create((GRect) { .origin = { bounds.origin.x + bounds.size.w - BITMAP_W - 1, bounds.origin.y + 35 }, .size = { BITMAP_W, BITMAP_H } });
+    up_bitmap_layer = bitmap_layer_create((GRect) { .origin = { buttonX, bounds.origin.y + pl->buttonMargin }, .size = { BITMAP_W, BITMAP_H } });
     bitmap_layer_set_bitmap(up_bitmap_layer, setup_bitmap);
     bitmap_layer_set_compositing_mode(up_bitmap_layer, CompOp);
     bitmap_layer_set_alignment(up_bitmap_layer, GAlignCenter);
     layer_add_child(window_layer, bitmap_layer_get_layer(up_bitmap_layer));
 
-    select_bitmap_layer = bitmap_layer_create((GRect) { .origin = { bounds.origin.x + bounds.size.w - BITMAP_W - 1, bounds.origin.y + (bounds.size.h - BITMAP_H) / 2 }, .size = { BITMAP_W, BITMAP_H } });
+    select_bitmap_layer = bitmap_layer_create((GRect) { .origin = { buttonX, bounds.origin.y + (bounds.size.h - BITMAP_H) / 2 }, .size = { BITMAP_W, BITMAP_H } });
     bitmap_layer_set_bitmap(select_bitmap_layer, start_bitmap);
     bitmap_layer_set_compositing_mode(select_bitmap_layer, CompOp);
     bitmap_layer_set_alignment(select_bitmap_layer, GAlignCenter);
     layer_add_child(window_layer, bitmap_layer_get_layer(select_bitmap_layer));
 
-    down_bitmap_layer = bitmap_layer_create((GRect) { .origin = { bounds.origin.x + bounds.size.w - BITMAP_W - 1, bounds.origin.y + bounds.size.h - BITMAP_H - 35 }, .size = { BITMAP_W, BITMAP_H } });
+    down_bitmap_layer = bitmap_layer_create((GRect) { .origin = { buttonX, bounds.origin.y + bounds.size.h - BITMAP_H - pl->buttonMargin }, .size = { BITMAP_W, BITMAP_H } });
     bitmap_layer_set_bitmap(down_bitmap_layer, reset_bitmap);
     bitmap_layer_set_compositing_mode(down_bitmap_layer, CompOp);
     bitmap_layer_set_alignment(down_bitmap_layer, GAlignCenter);
     layer_add_child(window_layer, bitmap_layer_get_layer(down_bitmap_layer));
 
-    if (timers[cur_timer].isRunning)
+    if (timer_is_running(cur_timer))
     {
         layer_set_hidden((Layer *)up_bitmap_layer, true);
         layer_set_hidden((Layer *)down_bitmap_layer, true);
         bitmap_layer_set_bitmap(select_bitmap_layer, pause_bitmap);
     }
 
-    const int inset =
-#ifdef PBL_PLATFORM_CHALK
-    -10;
-#else
-    0;
-#endif
-    icon_bitmap_layer = bitmap_layer_create((GRect) { .origin = { bounds.origin.x + 1 + inset, bounds.origin.y + 50 }, .size = { ICON_BITMAP_SIZE, ICON_BITMAP_SIZE } });
-    bitmap_layer_set_bitmap(icon_bitmap_layer, timer_icon_cache_get(timers[cur_timer].iconIdx));
+    icon_bitmap_layer = bitmap_layer_create((GRect) { .origin = { bounds.origin.x + pl->iconX, bounds.origin.y + pl->iconY }, .size = { ICON_BITMAP_SIZE, ICON_BITMAP_SIZE } });
+    timer_icon_layer_set(icon_bitmap_layer, &icon_shown, timer_icon_idx(cur_timer));
     bitmap_layer_set_compositing_mode(icon_bitmap_layer, CompOp);
     bitmap_layer_set_alignment(icon_bitmap_layer, GAlignCenter);
     layer_add_child(window_layer, bitmap_layer_get_layer(icon_bitmap_layer));
 
-    icon_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x + 2 + inset, bounds.origin.y + 50 + ICON_BITMAP_SIZE / 2 + 6 }, .size = { bounds.size.w, 28 } });
-    text_layer_set_text(icon_label_text_layer, timer_icon_labels[timers[cur_timer].iconIdx]);
+    icon_label_text_layer = text_layer_create((GRect) { .origin = { bounds.origin.x + pl->iconLabelX, bounds.origin.y + pl->iconY + ICON_BITMAP_SIZE / 2 + pl->iconLabelGap }, .size = { bounds.size.w, 28 } });
+    text_layer_set_text(icon_label_text_layer, timer_icon_labels[timer_icon_idx(cur_timer)]);
     text_layer_set_font(icon_label_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24));
     text_layer_set_text_alignment(icon_label_text_layer, GTextAlignmentLeft);
     text_layer_set_background_color(icon_label_text_layer, GColorClear);
@@ -1480,8 +1210,9 @@ static void timer_window_load(Window *window)
     layer_add_child(window_layer, s_timer_battery_layer);
 
     timer_update_time();
+    timer_view_set_focus(cur_timer);
 
-    if (timers[cur_timer].total_sec == 0 && !timers[cur_timer].isCountingUp)
+    if (timers[cur_timer].total_sec == 0 && !timer_is_counting_up(cur_timer))
     {
         app_timer_register(50, number_window_init_timer_callback, 0);
     }
@@ -1491,8 +1222,6 @@ static void timer_window_load(Window *window)
 
 static void timer_window_unload(Window *window)
 {
-    persist_write_int(KEY_FIRST_TIMER + cur_timer, timers[cur_timer].total_sec);
-
     text_layer_destroy(days_text_layer);
     text_layer_destroy(hours_text_layer);
     text_layer_destroy(time_text_layer);
@@ -1504,6 +1233,7 @@ static void timer_window_unload(Window *window)
     bitmap_layer_destroy(up_bitmap_layer);
     bitmap_layer_destroy(select_bitmap_layer);
     bitmap_layer_destroy(down_bitmap_layer);
+    timer_icon_layer_clear(icon_bitmap_layer, &icon_shown);
     bitmap_layer_destroy(icon_bitmap_layer);
     layer_destroy(s_timer_battery_layer);
     status_bar_layer_destroy(s_timer_status_bar);
@@ -1512,6 +1242,7 @@ static void timer_window_unload(Window *window)
     menu_layer_set_selected_index(s_menu_layer, timerMenuIndex(cur_timer), MenuRowAlignCenter, false);
 
     cur_timer = -999999; // invalid
+    timer_view_set_focus(-1);
 
     window_destroy(timer_window);
 }
@@ -1524,20 +1255,19 @@ static void timer_window_init(int timer_num)
     {
         // use existing timer
         cur_timer = timer_num;
-        timers[cur_timer].total_sec = persist_read_int(KEY_FIRST_TIMER + cur_timer);
     }
     else
     {
         // create a new timer
-        cur_timer = num_timers;
-        timers[cur_timer].total_sec = 0;
-        persist_write_int(TimerItemKey(cur_timer, KEY_TOTAL), timers[cur_timer].total_sec);
-        timers[cur_timer].isCountingUp = (timer_num == NEW_STOPWATCH);
-        persist_write_int(TimerItemKey(cur_timer, KEY_TYPE), timers[cur_timer].isCountingUp);
-        APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_window_init(%d) up:%d", timer_num, timers[cur_timer].isCountingUp);
-
-        num_timers++;
-        persist_write_int(KEY_NUM_TIMERS, num_timers);
+        int timer = timer_add(timer_num == NEW_STOPWATCH);
+
+        if (timer < 0)
+        {
+            return;
+        }
+
+        cur_timer = timer;
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ timer_window_init(%d) up:%d", timer_num, timer_is_counting_up(cur_timer));
     }
 
     timer_window = window_create();
@@ -1558,33 +1288,11 @@ static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer, uint16_t secti
 {
     switch (section_index) {
         case SECTION_TIMERS:
-        {
-            int count = 0;
+            return timer_list_count(TIMER_LIST_TIMERS);
 
-            for (int i = 0; i < num_timers; i++)
-            {
-                if (!timers[i].isCountingUp)
-                {
-                    count++;
-                }
-            }
-
-            return count;
-        }
         case SECTION_STOPWATCHES:
-        {
-            int count = 0;
-
-            for (int i = 0; i < num_timers; i++)
-            {
-                if (timers[i].isCountingUp)
-                {
-                    count++;
-                }
-            }
+            return timer_list_count(TIMER_LIST_STOPWATCHES);
 
-            return count;
-        }
         case SECTION_NEW_TIMER:
         case SECTION_NEW_STOPWATCH:
             return 1;
@@ -1602,13 +1310,13 @@ static int16_t menu_get_cell_height(MenuLayer *menu_layer, MenuIndex *cell_index
             return 30;
 
         case SECTION_NEW_TIMER:
-            if (num_timers < MAX_TIMERS)
+            if (timer_pool_can_add())
                 return 30;
             else
                 return 0;
 
         case SECTION_NEW_STOPWATCH:
-            if (num_timers < MAX_TIMERS)
+            if (timer_pool_can_add())
                 return 30;
             else
                 return 0;
@@ -1618,208 +1326,54 @@ static int16_t menu_get_cell_height(MenuLayer *menu_layer, MenuIndex *cell_index
     }
 }
 
-static bool s_tick = true;
-
 static void menu_draw_row_callback(GContext* ctx, const Layer *cell_layer, MenuIndex *cell_index, void *data)
 {
 #ifdef PBL_COLOR
     graphics_context_set_compositing_mode(ctx, GCompOpSet);
 #endif
-    GRect layer_frame = layer_get_frame((Layer*) cell_layer);
-    GSize layer_size = layer_frame.size;
-    char title[30];
+    const MenuRowLayout *layout = menu_row_layout(layer_get_frame((Layer*) cell_layer));
+    int label;
 
     switch (cell_index->section) {
         case SECTION_TIMERS:
         case SECTION_STOPWATCHES:
         {
-            int32_t time_delta = 0;
-            GBitmap *bmp = 0;
-            int bmpSize = 12;
             int index = timerIndex(cell_index);
+            TimerRow *row = timer_row_get(index);
+            GBitmap *bmpStatus = menu_row_status_bitmap(row);
+            int big = row->status == TIMER_ROW_ALERT;
 
-            if (cell_index->section == SECTION_STOPWATCHES)
-            {
-                time_delta = timers[index].elapsed_sec;
-
-                if (timers[index].isRunning)
-                {
-                    bmp = start_bitmap;
-                }
-                else if (timers[index].elapsed_sec > 0)
-                {
-                    bmp = pause_bitmap;
-                }
-                else
-                {
-                    bmp = 0;
-                }
-            }
-            else
-            {
-                if (timers[index].isRunning)
-                {
-                    time_delta = timers[index].total_sec - timers[index].elapsed_sec;
-                    bmp = start_bitmap;
-                }
-                else
-                {
-                    time_delta = timers[index].total_sec;
-
-                    if (timers[index].alert_sec > 0)
-                    {
-                        if (s_tick)
-                        {
-                            bmp = running_bitmap;
-                            bmpSize = 28;
-                        }
-                    }
-                    else if (timers[index].elapsed_sec > 0)
-                    {
-                        time_delta -= timers[index].elapsed_sec;
-                        bmp = pause_bitmap;
-                    }
-                    else
-                    {
-                        bmp = 0;
-                    }
-                }
-            }
-
-            if (s_tick && timers[index].alert_sec > 0)
-            {
-                snprintf(title, sizeof(title), "%s", timer_icon_labels[timers[index].iconIdx]);
-            }
-            else
-            {
-                uint32_t time = time_delta;
-                int days = time / 60 / 60 / 24;
-                int hours = time / 60 / 60 - days * 24;
-                int minutes = time / 60 - days * 24 * 60 - hours * 60;
-                int seconds = time - days * 24 * 60 * 60 - hours * 60 * 60 - minutes * 60;
-
-                if (days > 99)
-                {
-                    snprintf(title, sizeof(title), "%dd%02d", days, hours);
-                }
-                else if (days > 0)
-                {
-                    snprintf(title, sizeof(title), "%dd%02d:%02d", days, hours, minutes);
-                }
-                else if (hours > 0)
-                {
-                    snprintf(title, sizeof(title), "%2d:%02d:%02d", hours, minutes, seconds);
-                }
-                else
-                {
-                    snprintf(title, sizeof(title), "%2d:%02d", minutes, seconds);
-                }
-            }
-
-            GRect r;
-            GSize tsize = graphics_text_layout_get_content_size("999:00:00", fonts_get_system_font(FONT_KEY_GOTHIC_28), layer_frame, GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft);
-            const int bmpIconSize = 28;
-
-#ifndef PBL_PLATFORM_CHALK
-            if (bmp)
+            if (bmpStatus)
             {
-                r.origin.x = 10;
-                r.origin.y = (layer_size.h - bmpSize) / 2;
-                r.size.w = bmpSize;
-                r.size.h = r.size.w;
-                graphics_draw_bitmap_in_rect(ctx, bmp, r);
+                graphics_draw_bitmap_in_rect(ctx, bmpStatus, layout->status[big]);
             }
-            const int rightPad = 2;
-#else
-            const int rightPad = (layer_size.w - tsize.w - bmpIconSize - bmpSize - 2 * 2) / 2;
 
-#endif
-            r.origin.x = layer_size.w - bmpIconSize - rightPad;
-            r.origin.y = (layer_size.h - bmpIconSize) / 2;
-            r.size.w = bmpIconSize;
-            r.size.h = bmpIconSize;
-
-            GBitmap *bmpIcon = timer_icon_cache_get(timers[index].iconIdx);
+            GBitmap *bmpIcon = timer_row_icon(index);
             if (bmpIcon)
             {
-                graphics_draw_bitmap_in_rect(ctx, bmpIcon, r);
+                graphics_draw_bitmap_in_rect(ctx, bmpIcon, layout->icon[big]);
             }
 
-#ifdef PBL_PLATFORM_CHALK
-            r.origin.x = r.origin.x - bmpSize - 2;
-            r.origin.y = (layer_size.h - bmpSize) / 2;
-            r.size.w = bmpSize;
-            r.size.h = r.size.w;
-
-            if (bmp)
-            {
-                graphics_draw_bitmap_in_rect(ctx, bmp, r);
-            }
-#endif
-
             menu_cell_title_draw(ctx, cell_layer, ""); // HACK: needed for some reason to draw text below
-
-#ifdef PBL_PLATFORM_CHALK
-            r.origin.x = 0;
-            r.size.w = layer_size.w - bmpSize - bmpIconSize - rightPad - 2;
-#else
-            r.origin.x = layer_size.w - r.origin.x - 2;
-            r.size.w = layer_size.w - r.origin.x - r.size.w - 2;
-#endif
-            r.origin.y = -4;
-            r.size.h = tsize.h;
-            graphics_draw_text(ctx, title, fonts_get_system_font(FONT_KEY_GOTHIC_28), r, GTextOverflowModeTrailingEllipsis, GTextAlignmentRight, NULL);
-
-            break;
+            graphics_draw_text(ctx, row->title, s_row_font, layout->text[big], GTextOverflowModeTrailingEllipsis, GTextAlignmentRight, NULL);
+            return;
         }
 
         case SECTION_NEW_TIMER:
-            switch (cell_index->row) {
-                case 0:
-                    if (num_timers < MAX_TIMERS) {
-                        strncpy(title, "+ Timer", sizeof(title));
-                    } else {
-                        strncpy(title, "Max Timers", sizeof(title));
-                    }
-
-                    GSize tsize = graphics_text_layout_get_content_size(title, fonts_get_system_font(FONT_KEY_GOTHIC_28), layer_frame, GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter);
-                    const int pad = (layer_size.w - tsize.w) / 2;
-                    GRect r;
-                    r.origin.x =  pad;
-                    r.size.w = tsize.w;
-                    r.origin.y = -4;
-                    r.size.h = tsize.h;
-
-                    menu_cell_title_draw(ctx, cell_layer, ""); // HACK: needed for some reason to draw text below
-                    graphics_draw_text(ctx, title, fonts_get_system_font(FONT_KEY_GOTHIC_28), r, GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
-                    break;
-            }
+            label = timer_pool_can_add() ? ROW_ADD_TIMER : ROW_ADD_MAX;
             break;
 
         case SECTION_NEW_STOPWATCH:
-            switch (cell_index->row) {
-                case 0:
-                    if (num_timers < MAX_TIMERS) {
-                        strncpy(title, "+ Stopwatch", sizeof(title));
-                    } else {
-                        strncpy(title, "Max Timers", sizeof(title));
-                    }
-
-                    GSize tsize = graphics_text_layout_get_content_size(title, fonts_get_system_font(FONT_KEY_GOTHIC_28), layer_frame, GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter);
-                    const int pad = (layer_size.w - tsize.w) / 2;
-                    GRect r;
-                    r.origin.x =  pad;
-                    r.size.w = tsize.w;
-                    r.origin.y = -4;
-                    r.size.h = tsize.h;
-
-                    menu_cell_title_draw(ctx, cell_layer, ""); // HACK: needed for some reason to draw text below
-                    graphics_draw_text(ctx, title, fonts_get_system_font(FONT_KEY_GOTHIC_28), r, GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
-                    break;
-            }
+            label = timer_pool_can_add() ? ROW_ADD_STOPWATCH : ROW_ADD_MAX;
             break;
+
+        default:
+            return;
     }
-    s_tick = !s_tick;
+
+    // the sections adding a timer or a stopwatch have one row
+    menu_cell_title_draw(ctx, cell_layer, ""); // HACK: needed for some reason to draw text below
+    graphics_draw_text(ctx, row_add_labels[label], s_row_font, layout->add[label], GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
 }
 
 void menu_select_click_callback(MenuLayer *menu_layer, MenuIndex *cell_index, void *data)
@@ -1832,7 +1386,7 @@ void menu_select_click_callback(MenuLayer *menu_layer, MenuIndex *cell_index, vo
 
         case SECTION_NEW_TIMER:
             if (cell_index->row == 0) {
-                if (num_timers < MAX_TIMERS)
+                if (timer_pool_can_add())
                 {
                     timer_window_init(NEW_TIMER);
                 }
@@ -1841,7 +1395,7 @@ void menu_select_click_callback(MenuLayer *menu_layer, MenuIndex *cell_index, vo
 
         case SECTION_NEW_STOPWATCH:
             if (cell_index->row == 0) {
-                if (num_timers < MAX_TIMERS)
+                if (timer_pool_can_add())
                 {
                     timer_window_init(NEW_STOPWATCH);
                 }
@@ -1867,103 +1421,70 @@ void menu_select_long_click_callback(MenuLayer *menu_layer, MenuIndex *cell_inde
     }
 }
 
+static void menu_selection_changed_callback(MenuLayer *menu_layer, MenuIndex new_index, MenuIndex old_index, void *data)
+{
+    timer_row_icons_unpin_hidden();
+}
+
+static void wakeup_handler(WakeupId wakeup_id, int32_t cookie)
+{
+    // the timer's own expiry alerts; the wakeup was for a closed app
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ wakeup %d for timer %d while open", (int)wakeup_id, (int)cookie);
+}
+
 static void window_load(Window *window)
 {
     //APP_LOG(APP_LOG_LEVEL_DEBUG, "window_load() END free:%d, used:%d", (int) heap_bytes_free(), heap_bytes_used());
     Layer *window_layer = window_get_root_layer(window);
     GRect bounds = layer_get_bounds(window_layer);
 
-    running_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_RUNNING);
-    trash_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_TRASH);
-    start_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_START);
-    pause_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_PAUSE);
-    setup_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_SETUP);
-    reset_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_RESET);
-    vibe_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_VIBRATION);
-    stopwatch_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_STOPWATCH);
-
     timer_icon_cache_init();
+    menu_row_layout_init();
 
-    cur_timer = -999999; // invalid
+    running_bitmap = timer_glyph_load(SPRITE_RUNNING);
+    trash_bitmap = timer_glyph_load(SPRITE_TRASH);
+    start_bitmap = timer_glyph_load(SPRITE_START);
+    pause_bitmap = timer_glyph_load(SPRITE_PAUSE);
+    setup_bitmap = timer_glyph_load(SPRITE_SETUP);
+    reset_bitmap = timer_glyph_load(SPRITE_RESET);
+    vibe_bitmap = timer_glyph_load(SPRITE_VIBRATION);
+    stopwatch_bitmap = timer_glyph_load(SPRITE_STOPWATCH);
 
-    if (!persist_exists(KEY_NUM_TIMERS))
-    {
-        persist_write_int(TimerItemKey(0, KEY_TOTAL), 60);
-        persist_write_int(TimerItemKey(1, KEY_TOTAL), 5*60); // 5 min
-        persist_write_int(TimerItemKey(2, KEY_TOTAL), 10*60); // 10 min
-        persist_write_int(KEY_NUM_TIMERS, 3);
-    }
+    cur_timer = -999999; // invalid
 
-    num_timers = persist_read_int(KEY_NUM_TIMERS);
+    timer_view_init((TimerViewHandlers) {
+        .tick = timer_update_time,
+        .row_visible = menu_row_visible,
+        .rows_changed = menu_rows_changed,
+    });
+    timer_core_init((TimerCoreHandlers) {
+        .pool_resized = timer_rows_resize,
+        .expired = timer_expired,
+        .alerted = timer_alerted,
+        .fired = timer_fired,
+    });
+    timer_core_load();
 
-    int version = 0;
+    WakeupId launched_by = -1;
+    int32_t cookie;
 
-    if (persist_exists(KEY_VERSION))
+    if (launch_reason() == APP_LAUNCH_WAKEUP)
     {
-        version = persist_read_int(KEY_VERSION);
+        vibes_short_pulse();
+        wakeup_get_launch_event(&launched_by, &cookie);
     }
 
-    if (version >= 2 && persist_exists(KEY_SHUTDOWN_TIME))
-    {
-        time_t now_time = time(NULL);
-        time_t shutdown_time = persist_read_int(KEY_SHUTDOWN_TIME);
-        uint32_t elapsed = difftime(now_time, shutdown_time);
+    // the other wakeups stay scheduled while the app is open, in case it is not
+    // closed the way it should be
+    wakeup_plan_launch(launched_by);
+    wakeup_service_subscribe(wakeup_handler);
 
-        for (int i = 0; i < num_timers; i++)
-        {
-            timers[i].total_sec = persist_read_int(TimerItemKey(i, KEY_TOTAL));
-            timers[i].elapsed_sec = persist_read_int(TimerItemKey(i, KEY_ELAPSED));
+    APP_LOG(APP_LOG_LEVEL_INFO, "@@ heap %s: Timer %d bytes, %d of %d timers use %d bytes, max %d bytes, free %d, used %d",
+            PLATFORM_NAME, (int)sizeof(Timer), num_timers, timer_capacity, (int)(timer_capacity * sizeof(Timer)),
+            (int)(MAX_TIMERS * sizeof(Timer)), (int)heap_bytes_free(), (int)heap_bytes_used());
 
-            if (version == 2)
-            {
-                if (timers[i].elapsed_sec > 0)
-                {
-                    timers[i].elapsed_sec += elapsed;
-                }
-
-                if (timers[i].elapsed_sec > 0)
-                {
-                    timers[i].isRunning = true;
-                }
-            }
-            if (version >= 3)
-            {
-                timers[i].isRunning = persist_read_int(TimerItemKey(i, KEY_ISRUNNING));
-                if (timers[i].isRunning)
-                {
-                    timers[i].elapsed_sec += elapsed;
-                }
-            }
-            if (version >= 4)
-            {
-                timers[i].iconIdx = persist_read_int(TimerItemKey(i, KEY_ICON));
-            }
-            if (version >= 5)
-            {
-                timers[i].isCountingUp = persist_read_int(TimerItemKey(i, KEY_TYPE));
-                timers[i].vibeIdx = persist_read_int(TimerItemKey(i, KEY_VIBE));
-                timers[i].vibeRepeat = persist_read_int(TimerItemKey(i, KEY_VIBE_REPEAT));
-            }
-        }
-
-        if (launch_reason() == APP_LAUNCH_WAKEUP)
-        {
-            vibes_short_pulse();
-        }
-
-        persist_delete(KEY_SHUTDOWN_TIME);
-    }
-    else
-    {
-        for (int i = 0; i < num_timers; i++)
-        {
-            timers[i].total_sec = persist_read_int(TimerItemKey(i, KEY_TOTAL));
-        }
-    }
-
-    wakeup_cancel_all();
-
-    tick_timer_service_subscribe(SECOND_UNIT, &timer_handle_tick);
+    timer_rows_invalidate_all();
+    timer_view_schedule();
 
     // Set up the status bar last to ensure it is on top of other Layers
     s_status_bar = status_bar_layer_create();
@@ -1986,6 +1507,7 @@ static void window_load(Window *window)
         .draw_row = menu_draw_row_callback,
         .select_click = menu_select_click_callback,
         .select_long_click = menu_select_long_click_callback,
+        .selection_changed = menu_selection_changed_callback,
     });
 
     menu_layer_set_click_config_onto_window(s_menu_layer, window);
@@ -1994,81 +1516,40 @@ static void window_load(Window *window)
 #endif
     layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
     setupContentIndicators(window_layer, bounds, s_menu_layer, &s_indicator, &s_indicator_up_layer, &s_indicator_down_layer, &s_up_config, &s_down_config);
-    MenuIndex index = (MenuIndex){ .row = persist_read_int(KEY_SELECTED_MENU_ROW), .section = persist_read_int(KEY_SELECTED_MENU_SECTION)};
-    menu_layer_set_selected_index(s_menu_layer, index, MenuRowAlignCenter, false);
+    int section, row;
+    store_get_selection(&section, &row);
+    menu_layer_set_selected_index(s_menu_layer, (MenuIndex){ .row = row, .section = section }, MenuRowAlignCenter, false);
     //APP_LOG(APP_LOG_LEVEL_DEBUG, "window_load() END free:%d, used:%d", (int) heap_bytes_free(), heap_bytes_used());
 }
 
 static void window_appear(Window *window)
 {
+    // timers may have been edited in other windows
+    timer_rows_invalidate_all();
+    timer_row_icons_unpin_hidden();
     menu_layer_reload_data(s_menu_layer);
 }
 
 static void window_unload(Window *window)
 {
     //APP_LOG(APP_LOG_LEVEL_DEBUG, "window_unload() free:%d, used:%d", (int) heap_bytes_free(), heap_bytes_used());
-    MenuIndex index = menu_layer_get_selected_index(s_menu_layer);
-    persist_write_int(KEY_SELECTED_MENU_SECTION, index.section);
-    persist_write_int(KEY_SELECTED_MENU_ROW, index.row);
-    persist_write_int(KEY_VERSION, 5);
-    persist_write_int(KEY_NUM_TIMERS, num_timers);
-
-    time_t shutdown_time = time(NULL);
-    persist_write_int(KEY_SHUTDOWN_TIME, shutdown_time);
-
-    bool isRunning = false;
-    uint32_t running_remaining_sec = 1999999999;
-
-    for (int i = 0; i < num_timers; i++)
-    {
-        persist_write_int(TimerItemKey(i, KEY_TOTAL), timers[i].total_sec);
-        persist_write_int(TimerItemKey(i, KEY_ELAPSED), timers[i].elapsed_sec);
-        persist_write_int(TimerItemKey(i, KEY_ISRUNNING), timers[i].isRunning);
-        persist_write_int(TimerItemKey(i, KEY_ICON), timers[i].iconIdx);
-        persist_write_int(TimerItemKey(i, KEY_TYPE), timers[i].isCountingUp);
-        persist_write_int(TimerItemKey(i, KEY_VIBE), timers[i].vibeIdx);
-        persist_write_int(TimerItemKey(i, KEY_VIBE_REPEAT), timers[i].vibeRepeat);
-
-        if (timers[i].isRunning && !timers[i].isCountingUp)
-        {
-            isRunning = true;
-            uint32_t remaining_sec = timers[i].total_sec - timers[i].elapsed_sec;
-            if (remaining_sec < running_remaining_sec)
-            {
-                running_remaining_sec = remaining_sec;
-            }
-        }
-    }
+    MenuIndex selected = menu_layer_get_selected_index(s_menu_layer);
+    store_set_selection(selected.section, selected.row);
 
-    gbitmap_destroy(start_bitmap);
-    gbitmap_destroy(pause_bitmap);
-    gbitmap_destroy(setup_bitmap);
-    gbitmap_destroy(vibe_bitmap);
-    gbitmap_destroy(stopwatch_bitmap);
-    gbitmap_destroy(running_bitmap);
-    gbitmap_destroy(trash_bitmap);
-    gbitmap_destroy(reset_bitmap);
+    wakeup_plan_schedule();
 
+    // the UI glyphs are views owned by the icon cache
+    timer_view_deinit();
     timer_icon_cache_destroy();
+    timer_core_deinit();
     menu_layer_destroy(s_menu_layer);
+    s_menu_layer = NULL;
     layer_destroy(s_battery_layer);
     status_bar_layer_destroy(s_status_bar);
     layer_destroy(s_indicator_up_layer);
     layer_destroy(s_indicator_down_layer);
 
-    if (isRunning)
-    {
-        time_t wake_time = shutdown_time + running_remaining_sec - 8;
-        time_t now = time(NULL);
-
-        if (wake_time < now)
-        {
-            // took too long to shutdown so wakeup time is now in the past
-            wake_time = now + 5;
-        }
-
-        wakeup_schedule(wake_time, 0, true);
-    }
+    energy_dump("window_unload");
     //APP_LOG(APP_LOG_LEVEL_DEBUG, "window_unload() END free:%d, used:%d", (int) heap_bytes_free(), heap_bytes_used());
 }
 
@@ -2083,19 +1564,17 @@ static void init(void)
     });
     window_stack_push(window, true);
 
-    app_message_register_outbox_failed(outbox_failed_callback);
-    app_message_register_outbox_sent(outbox_sent_callback);
-    AppMessageResult result = app_message_open(64, 100);
-    if (result != APP_MSG_OK) {
-        APP_LOG(APP_LOG_LEVEL_ERROR, "init app_message_open failed. %s", translate_error(result));
-    }
+    outbox_init((OutboxHandlers) {
+        .pin = timeline_pin,
+    });
+    timeline_sync();
     //APP_LOG(APP_LOG_LEVEL_DEBUG, "init() END free:%d, used:%d", (int) heap_bytes_free(), heap_bytes_used());
 }
 
 static void deinit(void)
 {
     //APP_LOG(APP_LOG_LEVEL_DEBUG, "deinit() free:%d, used:%d", (int) heap_bytes_free(), heap_bytes_used());
-    app_message_deregister_callbacks();
+    outbox_deinit();
     window_destroy(window);
     //APP_LOG(APP_LOG_LEVEL_DEBUG, "deinit() END free:%d, used:%d", (int) heap_bytes_free(), heap_bytes_used());
 }
@@ -0,0 +1,1385 @@
+#include "timer_core.h"
+#include "energy.h"
+
+// Persistent storage keys
+#define KEY_NUM_TIMERS              1
+#define KEY_SELECTED_MENU_SECTION   2
+#define KEY_SELECTED_MENU_ROW       3
+#define KEY_SHUTDOWN_TIME           4
+#define KEY_VERSION                 5
+#define KEY_STORE                  10   // First chunk of the packed timer store
+// 20 is used by wakeup_plan.c, 21 and 22 by outbox.c
+#define KEY_FIRST_TIMER           100   // Legacy layout, see LegacyTimerItemKey
+
+
+Timer *timers = NULL;
+int timer_capacity = 0;
+int num_timers = 0;
+int timer_slots = 0;
+
+static TimerCoreHandlers s_handlers;
+
+// ------------------------- Timer Pool -------------------------
+
+static bool timer_pool_grow(int capacity)
+{
+    Timer *grown = realloc(timers, capacity * sizeof(Timer));
+
+    if (!grown)
+    {
+        return false;
+    }
+
+    memset(grown + timer_capacity, 0, (capacity - timer_capacity) * sizeof(Timer));
+    timers = grown;
+
+    if (s_handlers.pool_resized && !s_handlers.pool_resized(capacity))
+    {
+        // the UI cannot follow, so give the new slots back
+        if (timer_capacity == 0)
+        {
+            free(timers);
+            timers = NULL;
+        }
+        else
+        {
+            Timer *shrunk = realloc(timers, timer_capacity * sizeof(Timer));
+            timers = shrunk ? shrunk : timers;
+        }
+
+        return false;
+    }
+
+    timer_capacity = capacity;
+    return true;
+}
+
+// Make room for count timers; false if over the cap or out of memory
+bool timer_pool_reserve(int count)
+{
+    if (count > MAX_TIMERS)
+    {
+        return false;
+    }
+
+    if (count <= timer_capacity)
+    {
+        return true;
+    }
+
+    int capacity = (count + TIMER_POOL_CHUNK - 1) / TIMER_POOL_CHUNK * TIMER_POOL_CHUNK;
+
+    if (capacity > MAX_TIMERS)
+    {
+        capacity = MAX_TIMERS;
+    }
+
+    return timer_pool_grow(capacity);
+}
+
+// ------------------------- Timer Slots ------------------------
+//
+// A timer keeps its slot in timers[] until it is deleted, so a delete moves no other
+// timer and leaves their expiries, menu rows, pins and stored records alone. Freed
+// slots below timer_slots are zeroed, so they read as stopped timers with nothing to
+// do, and are chained into a free list for the next new timer.
+
+#define SLOT_USED   -2      // s_slot_next of a slot in use
+
+static int8_t s_slot_next[MAX_TIMERS];          // Next free slot, -1 at the end, or SLOT_USED
+static uint8_t s_slot_generation[MAX_TIMERS];   // Times the slot was freed
+static uint16_t s_slot_order[MAX_TIMERS];       // Creation order, sorts the menu lists
+static int s_slot_free = -1;                    // First free slot or -1
+
+_Static_assert(MAX_TIMERS <= 0x100, "slot does not fit the low byte of a TimerId");
+
+// True if room for one more timer is allocated or can be allocated within budget
+bool timer_pool_can_add(void)
+{
+    if (num_timers >= MAX_TIMERS)
+    {
+        return false;
+    }
+
+    return s_slot_free >= 0 || timer_slots < timer_capacity ||
+           heap_bytes_free() >= TIMER_POOL_CHUNK * sizeof(Timer) + TIMER_HEAP_RESERVE;
+}
+
+bool timer_is_used(int timer)
+{
+    return timer >= 0 && timer < timer_slots && s_slot_next[timer] == SLOT_USED;
+}
+
+TimerId timer_id(int timer)
+{
+    return (TimerId)s_slot_generation[timer] << 8 | timer;
+}
+
+// Slot of the timer an id was given to, or -1 if it was deleted since
+int timer_from_id(TimerId id)
+{
+    int timer = id & 0xFF;
+    return timer_is_used(timer) && s_slot_generation[timer] == id >> 8 ? timer : -1;
+}
+
+// A free slot, from the free list or else a new one; -1 if there is no room
+static int slot_alloc(void)
+{
+    int slot = s_slot_free;
+
+    if (slot >= 0)
+    {
+        s_slot_free = s_slot_next[slot];
+    }
+    else
+    {
+        if (!timer_pool_reserve(timer_slots + 1))
+        {
+            return -1;
+        }
+
+        slot = timer_slots++;
+    }
+
+    s_slot_next[slot] = SLOT_USED;
+    return slot;
+}
+
+static void slot_free(int slot)
+{
+    memset(&timers[slot], 0, sizeof(Timer));
+    s_slot_generation[slot]++;
+    s_slot_next[slot] = s_slot_free;
+    s_slot_free = slot;
+}
+
+// Chain the free slots once the restored ones are marked SLOT_USED
+static void slot_rebuild_free(void)
+{
+    s_slot_free = -1;
+    num_timers = 0;
+
+    for (int i = timer_slots - 1; i >= 0; i--)
+    {
+        if (s_slot_next[i] == SLOT_USED)
+        {
+            num_timers++;
+        }
+        else
+        {
+            s_slot_next[i] = s_slot_free;
+            s_slot_free = i;
+        }
+    }
+}
+
+// count timers in the first slots, in slot order, as older layouts stored them
+static void slot_restore_dense(int count)
+{
+    timer_slots = count;
+
+    for (int i = 0; i < count; i++)
+    {
+        s_slot_next[i] = SLOT_USED;
+        s_slot_generation[i] = 0;
+        s_slot_order[i] = i;
+    }
+
+    slot_rebuild_free();
+}
+
+// Free the pool and forget its slots, so nothing reads through the freed table
+static void timer_pool_destroy(void)
+{
+    free(timers);
+    timers = NULL;
+    timer_capacity = 0;
+    slot_restore_dense(0);
+
+    if (s_handlers.pool_resized)
+    {
+        s_handlers.pool_resized(0);
+    }
+}
+
+// ------------------------- Timer Clock ------------------------
+//
+// A running timer does not count ticks. It remembers the wall clock time at which it
+// would have had zero elapsed time, so elapsed and remaining time are always derived
+// from the clock and a late or missed tick can never skew it.
+
+static int64_t now_ms(void)
+{
+    time_t t;
+    uint16_t ms;
+    time_ms(&t, &ms);
+    return (int64_t)t * 1000 + ms;
+}
+
+static int64_t timer_start_ms(int timer)
+{
+    return (int64_t)timers[timer].start_time * 1000 + timers[timer].start_ms;
+}
+
+static void timer_set_start_ms(int timer, int64_t start)
+{
+    timers[timer].start_time = start / 1000;
+    timers[timer].start_ms = start % 1000;
+}
+
+static int64_t timer_elapsed_ms(int timer)
+{
+    if (timer_is_running(timer))
+    {
+        return now_ms() - timer_start_ms(timer);
+    }
+
+    return (int64_t)timers[timer].elapsed_sec * 1000;
+}
+
+uint32_t timer_elapsed_sec(int timer)
+{
+    int64_t elapsed = timer_elapsed_ms(timer);
+    return elapsed > 0 ? elapsed / 1000 : 0;
+}
+
+// Seconds left on a count down timer; zero once it has expired
+uint32_t timer_remaining_sec(int timer)
+{
+    uint32_t elapsed = timer_elapsed_sec(timer);
+    return elapsed < timers[timer].total_sec ? timers[timer].total_sec - elapsed : 0;
+}
+
+static void timer_clock_start(int timer)
+{
+    timer_set_start_ms(timer, now_ms() - (int64_t)timers[timer].elapsed_sec * 1000);
+    timer_set_running(timer, true);
+}
+
+static void timer_clock_stop(int timer)
+{
+    timers[timer].elapsed_sec = timer_elapsed_sec(timer);
+    timer_set_running(timer, false);
+}
+
+// Wall clock time in ms at which a running count down timer expires
+static int64_t timer_deadline_ms(int timer)
+{
+    return timer_start_ms(timer) + (int64_t)timers[timer].total_sec * 1000;
+}
+
+// ------------------------- Expiry Scheduler -------------------
+//
+// Timers with a pending event (an expiry or the next alert repeat) are kept in a
+// min-heap ordered by event time. A single AppTimer is armed for the top of the heap,
+// so expiries fire on time and nothing is polled.
+
+#define ALERT_REPEAT_MS     1000
+#define EXPIRY_MAX_DELAY_MS (24 * 60 * 60 * 1000)   // AppTimer delays are 32 bit ms
+
+static uint8_t s_expiry_heap[MAX_TIMERS];   // Timer indices, earliest event first
+static int8_t s_expiry_pos[MAX_TIMERS];     // Heap position of each timer or -1
+static int64_t s_expiry_at[MAX_TIMERS];     // Event time in ms of each timer
+static int s_expiry_count = 0;
+static AppTimer *s_expiry_timer = NULL;
+static bool s_expiry_firing = false;
+
+static void expiry_timer_callback(void *data);
+
+static void expiry_heap_swap(int a, int b)
+{
+    uint8_t t = s_expiry_heap[a];
+    s_expiry_heap[a] = s_expiry_heap[b];
+    s_expiry_heap[b] = t;
+    s_expiry_pos[s_expiry_heap[a]] = a;
+    s_expiry_pos[s_expiry_heap[b]] = b;
+}
+
+static void expiry_heap_up(int pos)
+{
+    while (pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+
+        if (s_expiry_at[s_expiry_heap[parent]] <= s_expiry_at[s_expiry_heap[pos]])
+        {
+            break;
+        }
+
+        expiry_heap_swap(pos, parent);
+        pos = parent;
+    }
+}
+
+static void expiry_heap_down(int pos)
+{
+    for (;;)
+    {
+        int smallest = pos;
+        int left = pos * 2 + 1;
+        int right = left + 1;
+
+        if (left < s_expiry_count && s_expiry_at[s_expiry_heap[left]] < s_expiry_at[s_expiry_heap[smallest]])
+        {
+            smallest = left;
+        }
+        if (right < s_expiry_count && s_expiry_at[s_expiry_heap[right]] < s_expiry_at[s_expiry_heap[smallest]])
+        {
+            smallest = right;
+        }
+        if (smallest == pos)
+        {
+            break;
+        }
+
+        expiry_heap_swap(pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void expiry_rearm(void)
+{
+    if (s_expiry_firing)
+    {
+        // the callback rearms once it is done
+        return;
+    }
+
+    if (s_expiry_count == 0)
+    {
+        if (s_expiry_timer)
+        {
+            app_timer_cancel(s_expiry_timer);
+            s_expiry_timer = NULL;
+        }
+        return;
+    }
+
+    int64_t delay = s_expiry_at[s_expiry_heap[0]] - now_ms();
+
+    if (delay < 0)
+    {
+        delay = 0;
+    }
+    else if (delay > EXPIRY_MAX_DELAY_MS)
+    {
+        delay = EXPIRY_MAX_DELAY_MS;
+    }
+
+    if (!s_expiry_timer || !app_timer_reschedule(s_expiry_timer, delay))
+    {
+        s_expiry_timer = app_timer_register(delay, expiry_timer_callback, NULL);
+    }
+}
+
+static void expiry_init(void)
+{
+    for (int i = 0; i < MAX_TIMERS; i++)
+    {
+        s_expiry_pos[i] = -1;
+    }
+
+    s_expiry_count = 0;
+}
+
+static void expiry_schedule(int timer, int64_t at)
+{
+    s_expiry_at[timer] = at;
+
+    if (s_expiry_pos[timer] < 0)
+    {
+        s_expiry_heap[s_expiry_count] = timer;
+        s_expiry_pos[timer] = s_expiry_count;
+        s_expiry_count++;
+    }
+
+    expiry_heap_up(s_expiry_pos[timer]);
+    expiry_heap_down(s_expiry_pos[timer]);
+    expiry_rearm();
+}
+
+static void expiry_cancel(int timer)
+{
+    int pos = s_expiry_pos[timer];
+
+    if (pos < 0)
+    {
+        return;
+    }
+
+    s_expiry_count--;
+    s_expiry_pos[timer] = -1;
+
+    if (pos < s_expiry_count)
+    {
+        int moved = s_expiry_heap[s_expiry_count];
+        s_expiry_heap[pos] = moved;
+        s_expiry_pos[moved] = pos;
+        expiry_heap_up(pos);
+        expiry_heap_down(s_expiry_pos[moved]);
+    }
+
+    expiry_rearm();
+}
+
+#define KEY_TOTAL        0
+#define KEY_ELAPSED      1
+#define KEY_ISRUNNING    2
+#define KEY_ICON         3
+#define KEY_TYPE         4
+#define KEY_VIBE         5
+#define KEY_VIBE_REPEAT  6
+
+// Storage versions up to 5 grouped each field of the first 10 timers
+#define LEGACY_MAX_TIMERS 10
+#define LegacyTimerItemKey(timer, offset) (KEY_FIRST_TIMER + LEGACY_MAX_TIMERS * (offset) + (timer))
+
+// ------------------------- Persistent Storage -----------------
+//
+// All timers are stored as one packed, versioned record written with persist_write_data
+// and split over as few PERSIST_DATA_MAX_LENGTH chunks as possible, starting at
+// KEY_STORE. Each chunk carries a CRC of its payload. The first chunk starts with a
+// StoreHeader, and a timer record never straddles two chunks.
+
+// There is one record per slot, free slots included, so a timer's record stays put
+// when another one is deleted.
+
+#define STORE_VERSION           9       // Continues the KEY_VERSION numbering
+#define STORE_MAX_CHUNKS        8
+#define STORE_FLAG_RUNNING      0x01
+#define STORE_FLAG_COUNTING_UP  0x02
+#define STORE_FLAG_USED         0x04    // Free slots only keep their generation
+
+typedef struct __attribute__((__packed__))
+{
+    uint8_t version;
+    uint8_t num_slots;
+    uint8_t selected_section;
+    uint8_t selected_row;
+} StoreHeader;
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t total_sec;
+    uint32_t elapsed_sec;   // Zero while running
+    int32_t start_time;     // Only while running
+    uint16_t start_ms;
+    uint8_t iconIdx;
+    uint8_t vibeIdx;
+    uint8_t vibeRepeat;
+    uint8_t flags;          // STORE_FLAG_*
+    uint8_t generation;
+    uint16_t order;
+} StoredTimer;
+
+typedef struct __attribute__((__packed__))
+{
+    uint16_t crc;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH - sizeof(uint16_t)];
+} StoreChunk;
+
+#define STORE_FIRST_CHUNK_RECORDS ((sizeof(((StoreChunk *)0)->data) - sizeof(StoreHeader)) / sizeof(StoredTimer))
+#define STORE_CHUNK_RECORDS (sizeof(((StoreChunk *)0)->data) / sizeof(StoredTimer))
+
+_Static_assert(STORE_FIRST_CHUNK_RECORDS + (STORE_MAX_CHUNKS - 1) * STORE_CHUNK_RECORDS >= MAX_TIMERS,
+               "store chunks cannot hold every slot");
+
+static uint8_t s_selected_section;
+static uint8_t s_selected_row;
+
+// CRC-16/CCITT-FALSE
+static uint16_t store_crc(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    while (len--)
+    {
+        crc ^= (uint16_t)*data++ << 8;
+
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static int store_chunk_first(int chunk)
+{
+    return chunk == 0 ? 0 : STORE_FIRST_CHUNK_RECORDS + (chunk - 1) * STORE_CHUNK_RECORDS;
+}
+
+static int store_chunk_count(int count)
+{
+    int chunks = 1;
+
+    while (store_chunk_first(chunks) < count)
+    {
+        chunks++;
+    }
+
+    return chunks;
+}
+
+static void store_encode(int timer, StoredTimer *rec)
+{
+    if (!timer_is_used(timer))
+    {
+        memset(rec, 0, sizeof(*rec));
+        rec->generation = s_slot_generation[timer];
+        return;
+    }
+
+    rec->total_sec = timers[timer].total_sec;
+    rec->elapsed_sec = timer_is_running(timer) ? 0 : timers[timer].elapsed_sec;
+    rec->start_time = timer_is_running(timer) ? timers[timer].start_time : 0;
+    rec->start_ms = timer_is_running(timer) ? timers[timer].start_ms : 0;
+    rec->iconIdx = timer_icon_idx(timer);
+    rec->vibeIdx = timer_vibe_idx(timer);
+    rec->vibeRepeat = timer_vibe_repeat(timer);
+    rec->flags = STORE_FLAG_USED | (timer_is_running(timer) ? STORE_FLAG_RUNNING : 0) |
+                 (timer_is_counting_up(timer) ? STORE_FLAG_COUNTING_UP : 0);
+    rec->generation = s_slot_generation[timer];
+    rec->order = s_slot_order[timer];
+}
+
+static void store_decode(int timer, const StoredTimer *rec)
+{
+    memset(&timers[timer], 0, sizeof(Timer));
+    timers[timer].total_sec = rec->total_sec;
+    timers[timer].elapsed_sec = rec->elapsed_sec;
+    timers[timer].start_time = rec->start_time;
+    timers[timer].start_ms = rec->start_ms;
+    timer_set_icon_idx(timer, rec->iconIdx < TIMER_ICON_ITEMS ? rec->iconIdx : 0);
+    timer_set_vibe_idx(timer, rec->vibeIdx < TIMER_VIBE_ITEMS ? rec->vibeIdx : 0);
+    timer_set_vibe_repeat(timer, rec->vibeRepeat < TIMER_VIBE_REPEATS ? rec->vibeRepeat : 0);
+    timer_set_running(timer, rec->flags & STORE_FLAG_RUNNING);
+    timer_set_counting_up(timer, rec->flags & STORE_FLAG_COUNTING_UP);
+    s_slot_next[timer] = rec->flags & STORE_FLAG_USED ? SLOT_USED : -1;
+    s_slot_generation[timer] = rec->generation;
+    s_slot_order[timer] = rec->order;
+}
+
+// Encode a chunk into buf, returning the payload length
+static size_t store_encode_chunk(int chunk, StoreChunk *buf)
+{
+    size_t len = 0;
+
+    if (chunk == 0)
+    {
+        StoreHeader header = {
+            .version = STORE_VERSION,
+            .num_slots = timer_slots,
+            .selected_section = s_selected_section,
+            .selected_row = s_selected_row,
+        };
+        memcpy(buf->data, &header, sizeof(header));
+        len = sizeof(header);
+    }
+
+    for (int i = store_chunk_first(chunk); i < timer_slots && i < store_chunk_first(chunk + 1); i++)
+    {
+        StoredTimer rec;
+        store_encode(i, &rec);
+        memcpy(buf->data + len, &rec, sizeof(rec));
+        len += sizeof(rec);
+    }
+
+    buf->crc = store_crc(buf->data, len);
+    return len;
+}
+
+// ------------------------- Write-behind -----------------------
+//
+// Changes are journaled as dirty timer records instead of being written right away.
+// The first change arms STORE_FLUSH_DELAY_MS of grace, and every change made in the
+// meantime is written by the same flush, so a crash loses at most that much state.
+// A flush only encodes and writes the chunks holding dirty records. A CRC match is
+// not taken to mean a chunk is unchanged, since a changed chunk can collide with it.
+
+#define STORE_FLUSH_DELAY_MS 2000
+
+static uint32_t s_store_dirty[(MAX_TIMERS + 31) / 32];
+static bool s_store_header_dirty;
+static uint8_t s_store_len[STORE_MAX_CHUNKS];  // Payload length in flash, 0 if none
+static AppTimer *s_store_flush_timer;
+
+static void store_flush_callback(void *data)
+{
+    s_store_flush_timer = NULL;
+    store_flush();
+}
+
+static void store_flush_later(void)
+{
+    if (!s_store_flush_timer)
+    {
+        s_store_flush_timer = app_timer_register(STORE_FLUSH_DELAY_MS, store_flush_callback, NULL);
+    }
+}
+
+void store_mark_dirty(int timer)
+{
+    if (timer < 0 || timer >= MAX_TIMERS)
+    {
+        return;
+    }
+
+    s_store_dirty[timer / 32] |= 1u << (timer % 32);
+    store_flush_later();
+}
+
+// Timer count or selection changed
+void store_mark_header_dirty(void)
+{
+    s_store_header_dirty = true;
+    store_flush_later();
+}
+
+// Every record from timer onwards changed
+static void store_mark_dirty_from(int timer)
+{
+    for (int i = timer; i < MAX_TIMERS; i++)
+    {
+        s_store_dirty[i / 32] |= 1u << (i % 32);
+    }
+
+    store_mark_header_dirty();
+}
+
+static bool store_chunk_dirty(int chunk)
+{
+    if (chunk == 0 && s_store_header_dirty)
+    {
+        return true;
+    }
+
+    for (int i = store_chunk_first(chunk); i < store_chunk_first(chunk + 1) && i < MAX_TIMERS; i++)
+    {
+        if (s_store_dirty[i / 32] & (1u << (i % 32)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// False if a chunk could not be written
+bool store_flush(void)
+{
+    if (s_store_flush_timer)
+    {
+        app_timer_cancel(s_store_flush_timer);
+        s_store_flush_timer = NULL;
+    }
+
+    int chunks = store_chunk_count(timer_slots);
+    int writes = 0;
+    bool written = true;
+
+    for (int chunk = 0; chunk < chunks; chunk++)
+    {
+        if (!store_chunk_dirty(chunk))
+        {
+            continue;
+        }
+
+        StoreChunk buf;
+        size_t len = store_encode_chunk(chunk, &buf);
+
+        if (persist_write_data(KEY_STORE + chunk, &buf, sizeof(buf.crc) + len) < 0)
+        {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "@@ store_flush chunk %d not written", chunk);
+            s_store_len[chunk] = 0;
+            written = false;
+            continue;
+        }
+
+        s_store_len[chunk] = len;
+        writes++;
+    }
+
+    for (int chunk = chunks; chunk < STORE_MAX_CHUNKS; chunk++)
+    {
+        if (s_store_len[chunk] || (s_store_header_dirty && persist_exists(KEY_STORE + chunk)))
+        {
+            persist_delete(KEY_STORE + chunk);
+            s_store_len[chunk] = 0;
+        }
+    }
+
+    memset(s_store_dirty, 0, sizeof(s_store_dirty));
+    s_store_header_dirty = false;
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ store_flush %d of %d chunks written", writes, chunks);
+    return written;
+}
+
+// Menu selection to restore on the next launch
+void store_set_selection(int section, int row)
+{
+    if (section != s_selected_section || row != s_selected_row)
+    {
+        s_selected_section = section;
+        s_selected_row = row;
+        store_mark_header_dirty();
+    }
+}
+
+void store_get_selection(int *section, int *row)
+{
+    *section = s_selected_section;
+    *row = s_selected_row;
+}
+
+// Write the whole store now; false if a chunk could not be written
+static bool store_save(void)
+{
+    store_mark_dirty_from(0);
+    return store_flush();
+}
+
+// Number of timers that could be allocated, at most count
+static int timer_pool_restore(int count)
+{
+    if (count > MAX_TIMERS)
+    {
+        count = MAX_TIMERS;
+    }
+
+    while (count > 0 && !timer_pool_reserve(count))
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ timer_pool_restore no memory for %d timers", count);
+        count -= TIMER_POOL_CHUNK;
+    }
+
+    return count > 0 ? count : 0;
+}
+
+// False if the header chunk of the store is unusable
+static bool store_load(void)
+{
+    StoreChunk buf;
+
+    for (int chunk = 0; chunk < STORE_MAX_CHUNKS; chunk++)
+    {
+        int len = persist_read_data(KEY_STORE + chunk, &buf, sizeof(buf)) - (int)sizeof(buf.crc);
+
+        if (len < 0 || store_crc(buf.data, len) != buf.crc)
+        {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "@@ store_load bad chunk %d", chunk);
+
+            if (chunk == 0)
+            {
+                return false;
+            }
+
+            // keep the timers before the damaged chunk
+            timer_slots = store_chunk_first(chunk);
+            break;
+        }
+
+        s_store_len[chunk] = len;
+
+        const uint8_t *data = buf.data;
+
+        if (chunk == 0)
+        {
+            StoreHeader header;
+
+            if (len < (int)sizeof(header))
+            {
+                return false;
+            }
+
+            memcpy(&header, data, sizeof(header));
+
+            if (header.version != STORE_VERSION)
+            {
+                APP_LOG(APP_LOG_LEVEL_ERROR, "@@ store_load unknown version %d", header.version);
+                return false;
+            }
+
+            timer_slots = timer_pool_restore(header.num_slots);
+            s_selected_section = header.selected_section;
+            s_selected_row = header.selected_row;
+            data += sizeof(header);
+            len -= sizeof(header);
+        }
+
+        for (int i = store_chunk_first(chunk); i < timer_slots && i < store_chunk_first(chunk + 1); i++)
+        {
+            if (len < (int)sizeof(StoredTimer))
+            {
+                timer_slots = i;
+                break;
+            }
+
+            StoredTimer rec;
+            memcpy(&rec, data, sizeof(rec));
+            store_decode(i, &rec);
+            data += sizeof(rec);
+            len -= sizeof(rec);
+        }
+
+        if (store_chunk_first(chunk + 1) >= timer_slots)
+        {
+            break;
+        }
+    }
+
+    slot_rebuild_free();
+    return true;
+}
+
+// Read the per-field layout of storage versions up to 5
+static void legacy_load(void)
+{
+    int version = 0;
+
+    if (persist_exists(KEY_VERSION))
+    {
+        version = persist_read_int(KEY_VERSION);
+    }
+
+    slot_restore_dense(timer_pool_restore(persist_read_int(KEY_NUM_TIMERS)));
+    s_selected_section = persist_read_int(KEY_SELECTED_MENU_SECTION);
+    s_selected_row = persist_read_int(KEY_SELECTED_MENU_ROW);
+
+    if (version >= 2 && persist_exists(KEY_SHUTDOWN_TIME))
+    {
+        time_t now_time = time(NULL);
+        time_t shutdown_time = persist_read_int(KEY_SHUTDOWN_TIME);
+        uint32_t elapsed = difftime(now_time, shutdown_time);
+
+        for (int i = 0; i < num_timers; i++)
+        {
+            timers[i].total_sec = persist_read_int(LegacyTimerItemKey(i, KEY_TOTAL));
+            timers[i].elapsed_sec = persist_read_int(LegacyTimerItemKey(i, KEY_ELAPSED));
+
+            if (version == 2)
+            {
+                if (timers[i].elapsed_sec > 0)
+                {
+                    timers[i].elapsed_sec += elapsed;
+                }
+
+                if (timers[i].elapsed_sec > 0)
+                {
+                    timer_set_running(i, true);
+                }
+            }
+            if (version >= 3)
+            {
+                timer_set_running(i, persist_read_int(LegacyTimerItemKey(i, KEY_ISRUNNING)));
+                if (timer_is_running(i))
+                {
+                    timers[i].elapsed_sec += elapsed;
+                }
+            }
+            if (version >= 4)
+            {
+                int icon = persist_read_int(LegacyTimerItemKey(i, KEY_ICON));
+                timer_set_icon_idx(i, icon >= 0 && icon < TIMER_ICON_ITEMS ? icon : 0);
+            }
+            if (version >= 5)
+            {
+                int vibe = persist_read_int(LegacyTimerItemKey(i, KEY_VIBE));
+                int repeat = persist_read_int(LegacyTimerItemKey(i, KEY_VIBE_REPEAT));
+                timer_set_counting_up(i, persist_read_int(LegacyTimerItemKey(i, KEY_TYPE)));
+                timer_set_vibe_idx(i, vibe >= 0 && vibe < TIMER_VIBE_ITEMS ? vibe : 0);
+                timer_set_vibe_repeat(i, repeat >= 0 && repeat < TIMER_VIBE_REPEATS ? repeat : 0);
+            }
+            if (timer_is_running(i))
+            {
+                timer_clock_start(i);
+            }
+        }
+    }
+    else
+    {
+        for (int i = 0; i < num_timers; i++)
+        {
+            timers[i].total_sec = persist_read_int(LegacyTimerItemKey(i, KEY_TOTAL));
+        }
+    }
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ legacy_load migrating %d timers from version %d", num_timers, version);
+}
+
+// Only once the store holding the migrated timers is written
+static void legacy_delete(void)
+{
+    for (int i = 0; i < LEGACY_MAX_TIMERS; i++)
+    {
+        for (int offset = KEY_TOTAL; offset <= KEY_VIBE_REPEAT; offset++)
+        {
+            persist_delete(LegacyTimerItemKey(i, offset));
+        }
+    }
+
+    persist_delete(KEY_NUM_TIMERS);
+    persist_delete(KEY_SELECTED_MENU_SECTION);
+    persist_delete(KEY_SELECTED_MENU_ROW);
+    persist_delete(KEY_SHUTDOWN_TIME);
+    persist_delete(KEY_VERSION);
+}
+
+// Timers of each list section in menu order and the row of each timer within its
+// section, so the menu callbacks never have to walk timers[]. Kept up to date when
+// timers are created, deleted or restored. A list is in creation order, which a reused
+// slot does not follow, so restoring sorts by s_slot_order.
+
+#define TimerList(timer) (timer_is_counting_up(timer) ? TIMER_LIST_STOPWATCHES : TIMER_LIST_TIMERS)
+
+static uint8_t s_list_timers[2][MAX_TIMERS];
+static uint8_t s_list_count[2];
+static uint8_t s_timer_row[MAX_TIMERS];
+static uint16_t s_next_order;
+
+static void timer_index_rebuild(void)
+{
+    s_list_count[TIMER_LIST_TIMERS] = 0;
+    s_list_count[TIMER_LIST_STOPWATCHES] = 0;
+    s_next_order = 0;
+
+    for (int i = 0; i < timer_slots; i++)
+    {
+        if (!timer_is_used(i))
+        {
+            continue;
+        }
+
+        // insertion sort; the lists are short and mostly in slot order already
+        int list = TimerList(i);
+        int row = s_list_count[list]++;
+
+        while (row > 0 && s_slot_order[s_list_timers[list][row - 1]] > s_slot_order[i])
+        {
+            s_list_timers[list][row] = s_list_timers[list][row - 1];
+            row--;
+        }
+
+        s_list_timers[list][row] = i;
+
+        if (s_slot_order[i] >= s_next_order)
+        {
+            s_next_order = s_slot_order[i] + 1;
+        }
+    }
+
+    for (int list = 0; list < 2; list++)
+    {
+        for (int row = 0; row < s_list_count[list]; row++)
+        {
+            s_timer_row[s_list_timers[list][row]] = row;
+        }
+    }
+}
+
+// Renumber the creation order from 0 once it is about to wrap
+static void timer_order_compact(void)
+{
+    s_next_order = 0;
+
+    for (int list = 0; list < 2; list++)
+    {
+        for (int row = 0; row < s_list_count[list]; row++)
+        {
+            s_slot_order[s_list_timers[list][row]] = s_next_order++;
+        }
+    }
+
+    store_mark_dirty_from(0);
+}
+
+// Called after a timer was given a slot; it goes at the end of its list
+static void timer_index_add(int timer)
+{
+    if (s_next_order == UINT16_MAX)
+    {
+        timer_order_compact();
+    }
+
+    int list = TimerList(timer);
+    s_slot_order[timer] = s_next_order++;
+    s_timer_row[timer] = s_list_count[list];
+    s_list_timers[list][s_list_count[list]++] = timer;
+}
+
+// Called before the slot of a timer is freed; the rows below move up
+static void timer_index_remove(int timer)
+{
+    int list = TimerList(timer);
+
+    for (int row = s_timer_row[timer]; row < s_list_count[list] - 1; row++)
+    {
+        s_list_timers[list][row] = s_list_timers[list][row + 1];
+        s_timer_row[s_list_timers[list][row]] = row;
+    }
+
+    s_list_count[list]--;
+}
+
+int timer_list_count(int list)
+{
+    return s_list_count[list];
+}
+
+// Timer shown in a row of a list, or -1
+int timer_list_timer(int list, int row)
+{
+    if (row < 0 || row >= s_list_count[list])
+    {
+        return -1;
+    }
+
+    return s_list_timers[list][row];
+}
+
+int timer_list_row(int timer)
+{
+    return s_timer_row[timer];
+}
+
+// ------------------------- Timer State ------------------------
+
+static void timer_vibe(int timer)
+{
+    switch (timer_vibe_idx(timer)) {
+        case 0:
+            vibes_double_pulse();
+            break;
+
+        case 1:
+            vibes_long_pulse();
+            break;
+
+        case 2:
+            vibes_short_pulse();
+            break;
+
+        case 3:
+        {
+            // Vibe pattern: {on, off, on, ...}
+            static const uint32_t segments[] = { 200, 100, 400 };
+            VibePattern pat = {
+                .durations = segments,
+                .num_segments = ARRAY_LENGTH(segments),
+            };
+            vibes_enqueue_custom_pattern(pat);
+            break;
+        }
+        default:
+            vibes_double_pulse();
+            break;
+    }
+}
+
+// Create a timer in a free slot; its index, or -1 if there is no room for it
+int timer_add(bool counting_up)
+{
+    int timer = slot_alloc();
+
+    if (timer < 0)
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ timer_create no memory for timer %d", num_timers);
+        return -1;
+    }
+
+    memset(&timers[timer], 0, sizeof(Timer));
+    timer_set_counting_up(timer, counting_up);
+
+    num_timers++;
+    timer_index_add(timer);
+    store_mark_dirty(timer);
+    store_mark_header_dirty();
+    return timer;
+}
+
+// Free the slot of a timer; no other timer moves, so only its own record is written
+void timer_remove(int timer)
+{
+    expiry_cancel(timer);
+    timer_index_remove(timer);
+    slot_free(timer);
+
+    num_timers--;
+    store_mark_dirty(timer);
+}
+
+// False if the timer cannot run: a count down timer without a duration
+bool timer_start(int timer)
+{
+    if (!timer_is_counting_up(timer) && timers[timer].total_sec == 0)
+    {
+        return false;
+    }
+
+    timer_clock_start(timer);
+    timer_set_alert_sec(timer, 0);
+    store_mark_dirty(timer);
+    expiry_cancel(timer);
+
+    if (!timer_is_counting_up(timer))
+    {
+        expiry_schedule(timer, timer_deadline_ms(timer));
+    }
+
+    return true;
+}
+
+void timer_stop(int timer)
+{
+    timer_clock_stop(timer);
+    expiry_cancel(timer);
+    store_mark_dirty(timer);
+}
+
+void timer_reset(int timer)
+{
+    timers[timer].elapsed_sec = 0;
+    store_mark_dirty(timer);
+}
+
+void timer_set_total_sec(int timer, uint32_t total_sec)
+{
+    timers[timer].total_sec = total_sec;
+    timers[timer].elapsed_sec = 0;
+    store_mark_dirty(timer);
+}
+
+static void timer_expire(int timer, int64_t at)
+{
+    timer_stop(timer);
+    timers[timer].elapsed_sec = 0;
+    timer_set_alert_sec(timer, 5 - timer_vibe_repeat(timer)); // vibe repeat
+    timer_vibe(timer);
+
+    if (timer_alert_sec(timer) > 0)
+    {
+        expiry_schedule(timer, at + ALERT_REPEAT_MS);
+    }
+
+    if (s_handlers.expired)
+    {
+        s_handlers.expired(timer);
+    }
+}
+
+static void timer_alert(int timer, int64_t at)
+{
+    timer_set_alert_sec(timer, timer_alert_sec(timer) - 1);
+    timer_vibe(timer);
+
+    if (timer_alert_sec(timer) > 0)
+    {
+        expiry_schedule(timer, at + ALERT_REPEAT_MS);
+    }
+
+    if (s_handlers.alerted)
+    {
+        s_handlers.alerted(timer);
+    }
+}
+
+static void expiry_timer_callback(void *data)
+{
+    s_expiry_timer = NULL;
+    s_expiry_firing = true;
+
+    int64_t now = now_ms();
+    bool fired = false;
+
+    while (s_expiry_count > 0 && s_expiry_at[s_expiry_heap[0]] <= now)
+    {
+        int timer = s_expiry_heap[0];
+        int64_t at = s_expiry_at[timer];
+
+        expiry_cancel(timer);
+
+        if (timer_is_running(timer) && !timer_is_counting_up(timer))
+        {
+            timer_expire(timer, at);
+            fired = true;
+        }
+        else if (timer_alert_sec(timer) > 0)
+        {
+            timer_alert(timer, at);
+            fired = true;
+        }
+    }
+
+    s_expiry_firing = false;
+    expiry_rearm();
+
+    if (fired && s_handlers.fired)
+    {
+        s_handlers.fired();
+    }
+}
+
+// ------------------------- Tick Rate --------------------------
+
+// Seconds before a timer drops under a day that the second tick is resumed. Must be
+// larger than one minute tick so the switch happens before seconds are shown.
+#define TICK_SECONDS_LEAD   (2 * 60)
+
+// Tick rate the timers need; the focused timer is shown in full and needs seconds
+TimeUnits timer_tick_units(int focused)
+{
+    TimeUnits units = 0;
+
+    for (int i = 0; i < timer_slots; i++)
+    {
+        if (timer_alert_sec(i) > 0)
+        {
+            return SECOND_UNIT;
+        }
+
+        if (!timer_is_running(i))
+        {
+            continue;
+        }
+
+        if (i == focused)
+        {
+            // the timer window always shows seconds
+            return SECOND_UNIT;
+        }
+
+        if (timer_is_counting_up(i))
+        {
+            if (timer_elapsed_sec(i) < SECONDS_PER_DAY)
+            {
+                return SECOND_UNIT;
+            }
+        }
+        else if (timer_remaining_sec(i) < SECONDS_PER_DAY + TICK_SECONDS_LEAD)
+        {
+            return SECOND_UNIT;
+        }
+
+        units = MINUTE_UNIT;
+    }
+
+    return units;
+}
+
+// ------------------------- Display Time ---------------------
+
+// Seconds a timer shows: elapsed for a stopwatch, remaining for a count down timer
+uint32_t timer_display_sec(int timer)
+{
+    return timer_is_counting_up(timer) ? timer_elapsed_sec(timer) : timer_remaining_sec(timer);
+}
+
+// Wall clock time in ms at which the seconds a running timer shows next cross a
+// multiple of unit_sec, so at the timer's own phase; -1 if that never happens
+int64_t timer_next_change_ms(int timer, uint32_t unit_sec)
+{
+    if (!timer_is_running(timer))
+    {
+        return -1;
+    }
+
+    uint32_t elapsed = timer_elapsed_sec(timer);
+    uint32_t next;
+
+    if (timer_is_counting_up(timer))
+    {
+        next = (elapsed / unit_sec + 1) * unit_sec;
+    }
+    else if (elapsed < timers[timer].total_sec)
+    {
+        // remaining drops from a multiple of unit_sec to one below it
+        next = timers[timer].total_sec - timer_remaining_sec(timer) / unit_sec * unit_sec + 1;
+    }
+    else
+    {
+        return -1;
+    }
+
+    return timer_start_ms(timer) + (int64_t)next * 1000;
+}
+
+// ------------------------- Lifecycle --------------------------
+
+void timer_core_init(TimerCoreHandlers handlers)
+{
+    s_handlers = handlers;
+}
+
+// Restore the timers, migrating older storage or creating the default timers
+void timer_core_load(void)
+{
+    timer_slots = 0;
+    memset(s_slot_generation, 0, sizeof(s_slot_generation));
+
+    if (persist_exists(KEY_NUM_TIMERS))
+    {
+        // the legacy keys outlive a migration whose store was not fully written, so
+        // they are read again rather than the partial store
+        legacy_load();
+
+        if (store_save())
+        {
+            legacy_delete();
+        }
+    }
+    else if (persist_exists(KEY_STORE))
+    {
+        if (!store_load())
+        {
+            // the damaged store is left as it is until a change writes over it
+            APP_LOG(APP_LOG_LEVEL_ERROR, "@@ timer_core_load store unreadable, starting empty");
+            slot_restore_dense(0);
+            s_selected_section = 0;
+            s_selected_row = 0;
+        }
+    }
+    else
+    {
+        slot_restore_dense(timer_pool_restore(3));
+
+        // without memory for them the list starts out empty
+        if (num_timers == 3)
+        {
+            timers[0].total_sec = 60;
+            timers[1].total_sec = 5*60; // 5 min
+            timers[2].total_sec = 10*60; // 10 min
+        }
+
+        store_save();
+    }
+
+    timer_index_rebuild();
+    expiry_init();
+
+    for (int i = 0; i < timer_slots; i++)
+    {
+        if (timer_is_running(i) && !timer_is_counting_up(i))
+        {
+            // timers that expired while the app was closed fire right away
+            expiry_schedule(i, timer_deadline_ms(i));
+        }
+    }
+}
+
+// Write pending changes and release the timers
+void timer_core_deinit(void)
+{
+    store_flush();
+
+    if (s_expiry_timer)
+    {
+        app_timer_cancel(s_expiry_timer);
+        s_expiry_timer = NULL;
+    }
+
+    s_expiry_count = 0;
+    timer_pool_destroy();
+    timer_index_rebuild();
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <pebble.h>
+#include "duration.h"
+#include "icon_table.auto.h"     // TIMER_ICON_ITEMS, generated from resources/icons.json
+
+// Timer state, persistence and scheduling without any UI; duration.c formats times. The
+// windows in timer.c drive it and are told about expiries through TimerCoreHandlers.
+// host/ builds it on a workstation against a stand-in for the SDK.
+
+// Hard cap on the number of timers. The timer table itself is allocated on demand, so
+// the cap only sizes the small index tables; creating a timer also needs heap to spare.
+#ifdef PBL_PLATFORM_APLITE
+#define MAX_TIMERS          32
+#define TIMER_HEAP_RESERVE  4096    // Heap kept free for windows and bitmaps
+#else
+#define MAX_TIMERS          64
+#define TIMER_HEAP_RESERVE  8192
+#endif
+#define TIMER_POOL_CHUNK    8       // Timers allocated at a time
+
+// A timer is kept compact so the table stays small on aplite: the small indices and
+// flags share one 16 bit word and are only reached through the accessors below.
+typedef struct
+{
+    uint32_t total_sec;     // Seconds in timer
+    uint32_t elapsed_sec;   // Seconds elapsed while stopped; stale while running
+    int32_t start_time;     // While running: wall clock time at which elapsed was zero
+    uint16_t start_ms;      // Milliseconds part of start_time
+    uint16_t bits;          // TIMER_BITS_* fields
+} Timer;
+
+_Static_assert(sizeof(Timer) <= 16, "Timer record over its size budget");
+
+#define TIMER_BITS_ICON_SHIFT       0       // Index into icon_ arrays
+#define TIMER_BITS_ICON_MASK        0x3F
+#define TIMER_BITS_VIBE_SHIFT       6       // Index into vibe_ arrays
+#define TIMER_BITS_VIBE_MASK        0x03
+#define TIMER_BITS_REPEAT_SHIFT     8       // Index into vibe_repeat_ arrays
+#define TIMER_BITS_REPEAT_MASK      0x07
+#define TIMER_BITS_ALERT_SHIFT      11      // Alert duration in seconds
+#define TIMER_BITS_ALERT_MASK       0x07
+#define TIMER_BITS_RUNNING          0x4000  // True iff timer is running
+#define TIMER_BITS_COUNTING_UP      0x8000  // Stopwatch if true
+
+extern Timer *timers;
+extern int timer_capacity;
+extern int num_timers;      // Timers in use
+extern int timer_slots;     // Slots of timers[] handed out; every timer is below
+
+// A timer is referred to by its slot in timers[], which it keeps until it is deleted.
+// A TimerId also counts how often the slot was reused, so one kept outside the app, as
+// in a timeline pin or a wakeup, never reaches the timer that took the slot over.
+typedef uint16_t TimerId;
+
+static inline int timer_bits_get(int timer, int shift, int mask)
+{
+    return (timers[timer].bits >> shift) & mask;
+}
+
+static inline void timer_bits_set(int timer, int shift, int mask, int value)
+{
+    timers[timer].bits = (timers[timer].bits & ~(mask << shift)) | ((value & mask) << shift);
+}
+
+static inline int timer_icon_idx(int timer)
+{
+    return timer_bits_get(timer, TIMER_BITS_ICON_SHIFT, TIMER_BITS_ICON_MASK);
+}
+
+static inline void timer_set_icon_idx(int timer, int icon)
+{
+    timer_bits_set(timer, TIMER_BITS_ICON_SHIFT, TIMER_BITS_ICON_MASK, icon);
+}
+
+static inline int timer_vibe_idx(int timer)
+{
+    return timer_bits_get(timer, TIMER_BITS_VIBE_SHIFT, TIMER_BITS_VIBE_MASK);
+}
+
+static inline void timer_set_vibe_idx(int timer, int vibe)
+{
+    timer_bits_set(timer, TIMER_BITS_VIBE_SHIFT, TIMER_BITS_VIBE_MASK, vibe);
+}
+
+static inline int timer_vibe_repeat(int timer)
+{
+    return timer_bits_get(timer, TIMER_BITS_REPEAT_SHIFT, TIMER_BITS_REPEAT_MASK);
+}
+
+static inline void timer_set_vibe_repeat(int timer, int repeat)
+{
+    timer_bits_set(timer, TIMER_BITS_REPEAT_SHIFT, TIMER_BITS_REPEAT_MASK, repeat);
+}
+
+static inline int timer_alert_sec(int timer)
+{
+    return timer_bits_get(timer, TIMER_BITS_ALERT_SHIFT, TIMER_BITS_ALERT_MASK);
+}
+
+static inline void timer_set_alert_sec(int timer, int sec)
+{
+    timer_bits_set(timer, TIMER_BITS_ALERT_SHIFT, TIMER_BITS_ALERT_MASK, sec > 0 ? sec : 0);
+}
+
+static inline bool timer_is_running(int timer)
+{
+    return timers[timer].bits & TIMER_BITS_RUNNING;
+}
+
+static inline void timer_set_running(int timer, bool running)
+{
+    timers[timer].bits = running ? timers[timer].bits | TIMER_BITS_RUNNING : timers[timer].bits & ~TIMER_BITS_RUNNING;
+}
+
+static inline bool timer_is_counting_up(int timer)
+{
+    return timers[timer].bits & TIMER_BITS_COUNTING_UP;
+}
+
+static inline void timer_set_counting_up(int timer, bool counting_up)
+{
+    timers[timer].bits = counting_up ? timers[timer].bits | TIMER_BITS_COUNTING_UP : timers[timer].bits & ~TIMER_BITS_COUNTING_UP;
+}
+
+_Static_assert(TIMER_ICON_ITEMS <= TIMER_BITS_ICON_MASK + 1, "Icon index does not fit Timer.bits");
+#define TIMER_VIBE_ITEMS 4
+#define TIMER_VIBE_REPEATS 5
+_Static_assert(TIMER_VIBE_ITEMS <= TIMER_BITS_VIBE_MASK + 1, "Vibe index does not fit Timer.bits");
+_Static_assert(TIMER_VIBE_REPEATS <= TIMER_BITS_REPEAT_MASK + 1, "Vibe repeat does not fit Timer.bits");
+
+// Menu sections the timers are listed in
+#define TIMER_LIST_TIMERS       0
+#define TIMER_LIST_STOPWATCHES  1
+
+// Callbacks into the UI. Any of them may be NULL.
+typedef struct
+{
+    bool (*pool_resized)(int capacity);     // Timer table resized; false keeps the old size
+    void (*expired)(int timer);             // Count down timer reached zero
+    void (*alerted)(int timer);             // Alert of an expired timer repeated
+    void (*fired)(void);                    // After a batch of expiries and alerts
+} TimerCoreHandlers;
+
+void timer_core_init(TimerCoreHandlers handlers);
+void timer_core_load(void);
+void timer_core_deinit(void);
+
+bool timer_pool_can_add(void);
+bool timer_pool_reserve(int count);
+
+bool timer_is_used(int timer);
+TimerId timer_id(int timer);
+int timer_from_id(TimerId id);
+
+uint32_t timer_elapsed_sec(int timer);
+uint32_t timer_remaining_sec(int timer);
+uint32_t timer_display_sec(int timer);
+int64_t timer_next_change_ms(int timer, uint32_t unit_sec);
+
+int timer_add(bool counting_up);
+void timer_remove(int timer);
+bool timer_start(int timer);
+void timer_stop(int timer);
+void timer_reset(int timer);
+void timer_set_total_sec(int timer, uint32_t total_sec);
+
+int timer_list_count(int list);
+int timer_list_timer(int list, int row);
+int timer_list_row(int timer);
+
+TimeUnits timer_tick_units(int focused);
+
+void store_mark_dirty(int timer);
+void store_mark_header_dirty(void);
+bool store_flush(void);
+void store_set_selection(int section, int row);
+void store_get_selection(int *section, int *row);
@@ -0,0 +1,365 @@
+#include "timer_view.h"
+#include "icon_cache.h"
+#include "energy.h"
+
+#define TIMER_ICON_LABEL(label) label,
+const char *const timer_icon_labels[TIMER_ICON_ITEMS] = { TIMER_ICON_TABLE(TIMER_ICON_LABEL) };
+
+static TimerViewHandlers s_handlers;
+static TimerViewStats s_stats;
+
+// ------------------------- Row Cache --------------------------
+//
+// The tick only re-renders rows of running or alerting timers and only reports a
+// change when a row that is on screen changed.
+
+static TimerRow *s_rows = NULL;     // One entry per timer pool slot
+static bool s_blink = true;
+
+static void timer_row_render(int timer, TimerRow *row)
+{
+    s_stats.renders++;
+    row->status = TIMER_ROW_NONE;
+    row->blink = false;
+    row->valid = true;
+
+    if (timer_is_running(timer))
+    {
+        row->status = TIMER_ROW_RUNNING;
+    }
+    else if (timer_alert_sec(timer) > 0)
+    {
+        if (s_blink)
+        {
+            row->status = TIMER_ROW_ALERT;
+        }
+    }
+    else if (timers[timer].elapsed_sec > 0)
+    {
+        row->status = TIMER_ROW_PAUSED;
+    }
+
+    if (s_blink && timer_alert_sec(timer) > 0)
+    {
+        row->blink = true;
+        snprintf(row->title, sizeof(row->title), "%s", timer_icon_labels[timer_icon_idx(timer)]);
+    }
+    else
+    {
+        timer_format_duration(row->title, sizeof(row->title), timer_display_sec(timer), DURATION_ROW);
+    }
+}
+
+TimerRow *timer_row_get(int timer)
+{
+    if (!s_rows[timer].valid)
+    {
+        timer_row_render(timer, &s_rows[timer]);
+    }
+
+    return &s_rows[timer];
+}
+
+void timer_row_invalidate(int timer)
+{
+    s_rows[timer].valid = false;
+}
+
+void timer_rows_invalidate_all(void)
+{
+    for (int i = 0; i < timer_capacity; i++)
+    {
+        s_rows[i].valid = false;
+    }
+}
+
+// Follows the timer pool; a TimerCoreHandlers.pool_resized handler
+bool timer_rows_resize(int capacity)
+{
+    if (capacity == 0)
+    {
+        free(s_rows);
+        s_rows = NULL;
+        return true;
+    }
+
+    TimerRow *grown = realloc(s_rows, capacity * sizeof(TimerRow));
+
+    if (!grown)
+    {
+        return false;
+    }
+
+    for (int i = timer_capacity; i < capacity; i++)
+    {
+        grown[i].valid = false;
+    }
+
+    s_rows = grown;
+    return true;
+}
+
+// Re-render the rows that can change by themselves; true if a visible one did
+bool timer_rows_update(void)
+{
+    bool dirty = false;
+
+    for (int i = 0; i < timer_slots; i++)
+    {
+        if (!timer_is_used(i) || (!timer_is_running(i) && timer_alert_sec(i) == 0 && s_rows[i].valid))
+        {
+            continue;
+        }
+
+        TimerRow row;
+        timer_row_render(i, &row);
+
+        TimerRow *cached = &s_rows[i];
+
+        if (cached->valid && cached->status == row.status && cached->blink == row.blink &&
+            strcmp(cached->title, row.title) == 0)
+        {
+            continue;
+        }
+
+        *cached = row;
+
+        if (!dirty && (!s_handlers.row_visible || s_handlers.row_visible(i)))
+        {
+            dirty = true;
+        }
+    }
+
+    return dirty;
+}
+
+// ------------------------- Row Icons --------------------------
+//
+// The icons of the rows on screen stay pinned, so redrawing the menu never evicts
+// and reloads their atlas pages. A row pins its icon when it is drawn and lets go
+// once it is off screen, its timer is deleted or shows another icon.
+
+static int8_t s_row_icons[MAX_TIMERS];      // Icon pinned by the row of each timer, or -1
+
+static void timer_row_icon_unpin(int timer)
+{
+    timer_icon_cache_unpin(s_row_icons[timer]);
+    s_row_icons[timer] = -1;
+}
+
+// Icon of a row being drawn
+GBitmap *timer_row_icon(int timer)
+{
+    int icon = timer_icon_idx(timer);
+    GBitmap *bmp = timer_icon_cache_get(icon);
+
+    if (s_row_icons[timer] != icon)
+    {
+        timer_row_icon_unpin(timer);
+
+        if (bmp)
+        {
+            timer_icon_cache_pin(icon);
+            s_row_icons[timer] = icon;
+        }
+    }
+
+    return bmp;
+}
+
+// Let go of the icons of rows that scrolled off screen or whose timer is gone
+void timer_row_icons_unpin_hidden(void)
+{
+    for (int i = 0; i < MAX_TIMERS; i++)
+    {
+        if (s_row_icons[i] >= 0 &&
+            (!timer_is_used(i) || (s_handlers.row_visible && !s_handlers.row_visible(i))))
+        {
+            timer_row_icon_unpin(i);
+        }
+    }
+}
+
+// ------------------------- Timer Window Time ------------------
+
+void timer_time_text(int timer, TimerTimeText *text)
+{
+    uint32_t sec = timer_display_sec(timer);
+    TimerDuration d = timer_duration(sec);
+
+    text->show_days = d.days > 0;
+    text->show_hours = d.hours > 0 || d.days > 0;
+
+    if (text->show_days)
+    {
+        timer_format_duration(text->days, sizeof(text->days), sec, DURATION_DAYS);
+    }
+
+    if (text->show_hours)
+    {
+        timer_format_duration(text->hours, sizeof(text->hours), sec, DURATION_HOURS);
+    }
+
+    timer_format_duration(text->time, sizeof(text->time), sec, DURATION_MIN_SEC);
+}
+
+// ------------------------- Tick Scheduler ---------------------
+//
+// Only subscribe to the tick rate the screen actually needs. Anything showing seconds,
+// alerting, or getting close to expiry needs the second tick. Rows of timers with a
+// day or more on the clock show no seconds, but their minute turns at the timer's own
+// phase rather than the wall clock's, so instead of the minute tick a one-shot
+// AppTimer wakes for the next row that changes.
+
+#define MINUTE_SEC  60
+
+static TimeUnits s_tick_units = 0;
+static AppTimer *s_minute_timer = NULL;
+static int s_focused = -1;          // Timer shown in its own window, or -1
+
+static void timer_view_minute_callback(void *data)
+{
+    s_minute_timer = NULL;
+
+    time_t now = time(NULL);
+    timer_view_tick(localtime(&now), MINUTE_UNIT);
+}
+
+static void timer_view_minute_cancel(void)
+{
+    if (s_minute_timer)
+    {
+        app_timer_cancel(s_minute_timer);
+        s_minute_timer = NULL;
+    }
+}
+
+// Wake when the first running timer shows its next minute
+static void timer_view_minute_arm(void)
+{
+    int64_t next = -1;
+
+    for (int i = 0; i < timer_slots; i++)
+    {
+        int64_t at = timer_next_change_ms(i, MINUTE_SEC);
+
+        if (at >= 0 && (next < 0 || at < next))
+        {
+            next = at;
+        }
+    }
+
+    if (next < 0)
+    {
+        timer_view_minute_cancel();
+        return;
+    }
+
+    time_t t;
+    uint16_t ms;
+    time_ms(&t, &ms);
+    int64_t delay = next - ((int64_t)t * 1000 + ms);
+
+    if (delay < 0)
+    {
+        delay = 0;
+    }
+
+    if (!s_minute_timer || !app_timer_reschedule(s_minute_timer, delay))
+    {
+        s_minute_timer = app_timer_register(delay, timer_view_minute_callback, NULL);
+    }
+}
+
+void timer_view_schedule(void)
+{
+    TimeUnits units = timer_tick_units(s_focused);
+
+    if (units == MINUTE_UNIT)
+    {
+        timer_view_minute_arm();
+        units = 0;
+    }
+    else
+    {
+        timer_view_minute_cancel();
+    }
+
+    if (units == s_tick_units)
+    {
+        return;
+    }
+
+    if (units == 0)
+    {
+        tick_timer_service_unsubscribe();
+    }
+    else
+    {
+        tick_timer_service_subscribe(units, timer_view_tick);
+    }
+
+    s_tick_units = units;
+}
+
+// Timer shown in full, which needs the second tick while it runs; -1 for none
+void timer_view_set_focus(int timer)
+{
+    s_focused = timer;
+    timer_view_schedule();
+}
+
+void timer_view_tick(struct tm *tick_time, TimeUnits units_changed)
+{
+    ENERGY_COUNT(ticks, 1);
+    s_blink = tick_time->tm_sec & 1;
+
+    if (s_handlers.tick)
+    {
+        s_handlers.tick();
+    }
+
+    if (timer_rows_update() && s_handlers.rows_changed)
+    {
+        s_handlers.rows_changed();
+    }
+
+    timer_view_schedule();
+}
+
+// ------------------------- Lifecycle --------------------------
+
+// Before timer_core_load, which sizes the row cache through timer_rows_resize
+void timer_view_init(TimerViewHandlers handlers)
+{
+    s_handlers = handlers;
+    s_blink = true;
+    s_focused = -1;
+    s_tick_units = 0;
+    s_minute_timer = NULL;
+    memset(s_row_icons, -1, sizeof(s_row_icons));
+}
+
+// Before timer_icon_cache_destroy, as it lets go of the row icons
+void timer_view_deinit(void)
+{
+    for (int i = 0; i < MAX_TIMERS; i++)
+    {
+        timer_row_icon_unpin(i);
+    }
+
+    if (s_tick_units)
+    {
+        tick_timer_service_unsubscribe();
+        s_tick_units = 0;
+    }
+
+    timer_view_minute_cancel();
+
+    s_focused = -1;
+}
+
+TimerViewStats timer_view_stats(void)
+{
+    return s_stats;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <pebble.h>
+#include "timer_core.h"
+
+// What the menu rows and the timer window show of the timers, and the tick that keeps
+// it current, without any layers. timer.c draws it; host/sim.c and host/bench.c drive
+// the same code against the stand-in for the SDK.
+
+// Status glyph at the left of a row
+typedef enum
+{
+    TIMER_ROW_NONE,
+    TIMER_ROW_RUNNING,
+    TIMER_ROW_PAUSED,
+    TIMER_ROW_ALERT,        // Drawn at full icon size, in the blink phase only
+} TimerRowStatus;
+
+// What a timer row last showed. Rows of stopped timers are rendered once and kept
+// until their timer is changed.
+typedef struct
+{
+    char title[30];         // Time or, while an alert blinks, the icon label
+    uint8_t status;         // TimerRowStatus
+    bool blink;             // Alert blink phase the row was rendered in
+    bool valid;
+} TimerRow;
+
+// The parts of the timer window's time; days and hours are hidden when zero
+typedef struct
+{
+    char days[12];
+    char hours[10];
+    char time[20];
+    bool show_days;
+    bool show_hours;
+} TimerTimeText;
+
+// Callbacks into the UI. Any of them may be NULL.
+typedef struct
+{
+    void (*tick)(void);                 // Every tick, before the rows are updated
+    bool (*row_visible)(int timer);     // Row is on screen; all rows are if NULL
+    void (*rows_changed)(void);         // A visible row changed on a tick
+} TimerViewHandlers;
+
+typedef struct
+{
+    uint32_t renders;       // Rows rendered
+} TimerViewStats;
+
+extern const char *const timer_icon_labels[TIMER_ICON_ITEMS];
+
+void timer_view_init(TimerViewHandlers handlers);
+void timer_view_deinit(void);
+
+bool timer_rows_resize(int capacity);
+TimerRow *timer_row_get(int timer);
+void timer_row_invalidate(int timer);
+void timer_rows_invalidate_all(void);
+bool timer_rows_update(void);
+
+GBitmap *timer_row_icon(int timer);
+void timer_row_icons_unpin_hidden(void);
+
+void timer_time_text(int timer, TimerTimeText *text);
+
+void timer_view_set_focus(int timer);
+void timer_view_schedule(void);
+void timer_view_tick(struct tm *tick_time, TimeUnits units_changed);
+
+TimerViewStats timer_view_stats(void);
@@ -0,0 +1,263 @@
+#include "wakeup_plan.h"
+#include "timer_core.h"
+#include "energy.h"
+
+// Persistent storage key, next to those of timer_core.c
+#define KEY_WAKEUP_PLAN         20      // WakeupPlan
+
+#define LATENCY_WEIGHT          4       // A new measurement counts 1/LATENCY_WEIGHT
+
+typedef struct
+{
+    WakeupId id;
+    int32_t at;                 // Wakeup time, zero if the entry is unused
+} PlannedWakeup;
+
+// Kept as one record, written only at exit
+typedef struct
+{
+    int32_t latency_ms;         // Mean launch latency
+    PlannedWakeup wakeups[WAKEUP_PLAN_SLOTS];
+} WakeupPlan;
+
+static WakeupPlan s_plan = { .latency_ms = WAKEUP_PLAN_LATENCY_MS };
+static bool s_plan_dirty = false;
+static bool s_plan_unknown = false;     // No record, so the OS may hold wakeups it misses
+
+// ------------------------- Launch -----------------------------
+
+static int64_t now_ms(void)
+{
+    time_t t;
+    uint16_t ms;
+
+    time_ms(&t, &ms);
+    return (int64_t)t * 1000 + ms;
+}
+
+static void plan_load(void)
+{
+    s_plan_dirty = false;
+    s_plan_unknown = persist_read_data(KEY_WAKEUP_PLAN, &s_plan, sizeof(s_plan)) != (int)sizeof(s_plan);
+
+    if (s_plan_unknown)
+    {
+        memset(&s_plan, 0, sizeof(s_plan));
+        s_plan.latency_ms = WAKEUP_PLAN_LATENCY_MS;
+    }
+}
+
+// The wakeup planned for at launched the app now
+static void plan_measure(int32_t at)
+{
+    int64_t latency_ms = now_ms() - (int64_t)at * 1000;
+
+    // a launch held back by the watch being off says nothing about the next one
+    if (latency_ms < 0 || latency_ms > WAKEUP_PLAN_LEAD_MAX_SEC * 1000)
+    {
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ wakeup launch %d ms late, not counted", (int)latency_ms);
+        return;
+    }
+
+    s_plan.latency_ms += ((int32_t)latency_ms - s_plan.latency_ms) / LATENCY_WEIGHT;
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ wakeup launch %d ms late, mean %d ms, lead %d s",
+            (int)latency_ms, (int)s_plan.latency_ms, wakeup_plan_lead_sec());
+}
+
+void wakeup_plan_launch(WakeupId launched_by)
+{
+    plan_load();
+
+    for (int i = 0; i < WAKEUP_PLAN_SLOTS; i++)
+    {
+        PlannedWakeup *wakeup = &s_plan.wakeups[i];
+
+        if (wakeup->at && wakeup->id == launched_by)
+        {
+            // the OS forgets a wakeup once it has fired
+            plan_measure(wakeup->at);
+            wakeup->at = 0;
+            s_plan_dirty = true;
+            break;
+        }
+    }
+}
+
+int wakeup_plan_lead_sec(void)
+{
+    // twice the mean, so a slower than usual launch still comes before the expiry
+    int lead_sec = (2 * s_plan.latency_ms + 999) / 1000;
+
+    if (lead_sec < WAKEUP_PLAN_LEAD_MIN_SEC)
+    {
+        return WAKEUP_PLAN_LEAD_MIN_SEC;
+    }
+    if (lead_sec > WAKEUP_PLAN_LEAD_MAX_SEC)
+    {
+        return WAKEUP_PLAN_LEAD_MAX_SEC;
+    }
+    return lead_sec;
+}
+
+// ------------------------- Planning ---------------------------
+
+// Earliest launch time, at or after from, for the expiry of a running count down;
+// 0 if there is none. *cookie is the id of its timer.
+static time_t plan_next(time_t now, time_t from, int lead_sec, int32_t *cookie)
+{
+    time_t next = 0;
+
+    for (int i = 0; i < timer_slots; i++)
+    {
+        if (!timer_is_used(i) || !timer_is_running(i) || timer_is_counting_up(i))
+        {
+            continue;
+        }
+
+        time_t at = now + (time_t)timer_remaining_sec(i) - lead_sec;
+
+        if (at < now + WAKEUP_PLAN_MIN_SEC)
+        {
+            // too close to launch ahead of the expiry
+            at = now + WAKEUP_PLAN_MIN_SEC;
+        }
+
+        if (at >= from && (!next || at < next))
+        {
+            next = at;
+            *cookie = timer_id(i);
+        }
+    }
+
+    return next;
+}
+
+// Index of the wanted time that a wakeup at at serves: one still ahead of it by
+// no more than the lead. -1 if none does.
+static int plan_match(const time_t *wanted, int count, time_t at, int lead_sec)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (at <= wanted[i] && at >= wanted[i] - lead_sec)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static WakeupId plan_add(time_t *at, int32_t cookie, time_t now)
+{
+    WakeupId id = wakeup_schedule(*at, cookie, true);
+
+    if (id == E_RANGE && *at - WAKEUP_PLAN_SPACING_SEC >= now + WAKEUP_PLAN_MIN_SEC)
+    {
+        // another wakeup is too close, perhaps of another app; launch earlier instead
+        *at -= WAKEUP_PLAN_SPACING_SEC;
+        id = wakeup_schedule(*at, cookie, true);
+    }
+
+    if (id < 0)
+    {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "@@ wakeup at %d not scheduled, error %d", (int)*at, (int)id);
+    }
+    return id;
+}
+
+void wakeup_plan_schedule(void)
+{
+    time_t now = time(NULL);
+    int lead_sec = wakeup_plan_lead_sec();
+    time_t wanted[WAKEUP_PLAN_SLOTS];
+    int32_t cookies[WAKEUP_PLAN_SLOTS];
+    bool covered[WAKEUP_PLAN_SLOTS];
+    int count = 0;
+
+    if (s_plan_unknown)
+    {
+        // wakeups of an older version, or of a lost record, would otherwise hold
+        // slots and launch the app for nothing
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ wakeup plan not found, cancelling all wakeups");
+        wakeup_cancel_all();
+        s_plan_unknown = false;
+        s_plan_dirty = true;
+    }
+
+    // the next launches, each covering the expiries up to the next possible wakeup
+    for (time_t from = now; count < WAKEUP_PLAN_SLOTS; count++)
+    {
+        wanted[count] = plan_next(now, from, lead_sec, &cookies[count]);
+        if (!wanted[count])
+        {
+            break;
+        }
+        covered[count] = false;
+        from = wanted[count] + WAKEUP_PLAN_SPACING_SEC;
+    }
+
+    // keep the wakeups that still serve a launch, cancel the rest
+    for (int i = 0; i < WAKEUP_PLAN_SLOTS; i++)
+    {
+        PlannedWakeup *wakeup = &s_plan.wakeups[i];
+        time_t at;
+        int match = -1;
+
+        if (!wakeup->at)
+        {
+            continue;
+        }
+
+        if (wakeup_query(wakeup->id, &at))
+        {
+            match = plan_match(wanted, count, at, lead_sec);
+            if (match < 0 || covered[match])
+            {
+                wakeup_cancel(wakeup->id);
+                match = -1;
+            }
+        }
+
+        if (match >= 0)
+        {
+            covered[match] = true;
+        }
+        else
+        {
+            // fired while the app was open, or no longer wanted
+            wakeup->at = 0;
+            s_plan_dirty = true;
+        }
+    }
+
+    // schedule the launches no kept wakeup serves
+    for (int i = 0, slot = 0; i < count; i++)
+    {
+        if (covered[i])
+        {
+            continue;
+        }
+
+        while (s_plan.wakeups[slot].at)
+        {
+            slot++;
+        }
+
+        time_t at = wanted[i];
+        WakeupId id = plan_add(&at, cookies[i], now);
+        if (id >= 0)
+        {
+            s_plan.wakeups[slot].id = id;
+            s_plan.wakeups[slot].at = at;
+            s_plan_dirty = true;
+        }
+    }
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "@@ wakeup plan %d launches, lead %d s%s", count, lead_sec, s_plan_dirty ? "" : ", unchanged");
+
+    if (s_plan_dirty)
+    {
+        persist_write_data(KEY_WAKEUP_PLAN, &s_plan, sizeof(s_plan));
+        s_plan_dirty = false;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pebble.h>
+
+// Wakeups that launch the app ahead of the expiries of running count down timers
+// while it is closed. The next expiries fill every wakeup slot the OS gives the app;
+// expiries closer together than the OS lets wakeups be are covered by the launch of
+// the first of them. The wakeups are tracked in persistent storage, so the plan made
+// at exit only cancels and schedules the ones that changed, and wakeups still due
+// are left in place while the app is open. Without a record, every wakeup of the
+// app is cancelled before planning, since the plan cannot tell which are its own.
+//
+// How far ahead of an expiry to launch is learned from how late wakeup launches
+// arrive after their wakeup time.
+
+#define WAKEUP_PLAN_SLOTS           8       // Wakeups the OS keeps for one app
+#define WAKEUP_PLAN_SPACING_SEC     60      // The OS refuses wakeups closer than this
+#define WAKEUP_PLAN_MIN_SEC         5       // Closest ahead a wakeup is scheduled
+#define WAKEUP_PLAN_LEAD_MIN_SEC    2
+#define WAKEUP_PLAN_LEAD_MAX_SEC    30
+#define WAKEUP_PLAN_LATENCY_MS      4000    // Until one is measured, an 8 s lead
+
+// The app is launched, by wakeup launched_by or by the user (launched_by < 0)
+void wakeup_plan_launch(WakeupId launched_by);
+
+// Plan the wakeups for the timers as they are; call before timer_core_deinit
+void wakeup_plan_schedule(void);
+
+int wakeup_plan_lead_sec(void);
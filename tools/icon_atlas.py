@@ -0,0 +1,332 @@
+"""Pack the timer icons and UI glyphs into one sprite atlas resource per platform.
+
+The atlas is a raw resource read by src/icon_cache.c. Sprites are grouped into pages
+of up to PAGE_SPRITES sprites of the same size. Each page is stored ready to copy into
+a blank GBitmap: already in the watch's pixel format, with its own palette and the
+smallest bit depth its colors fit in. Loading a page is then one flash read with no
+PNG decoding, and the pixels stay small where a page needs few colors.
+
+Layout, little endian:
+
+    AtlasHeader     magic "TIA1", sprite count, page count
+    AtlasPage[]     data offset, bytes per row, size, GBitmapFormat, palette
+    AtlasSprite[]   page, x, y, w, h
+    pixel data
+
+The sprites and their order come from resources/icons.json, which also gives each
+timer icon its label. The same manifest generates src/icon_table.auto.h, so adding an
+icon is one manifest line and its PNGs.
+
+Only the standard library is used, so it runs inside waf on any SDK install.
+"""
+
+import json
+import os
+import struct
+import zlib
+
+# The icons and glyphs, in sprite order: the timer icons by iconIdx, then the UI glyphs
+MANIFEST = 'icons.json'
+
+PAGE_SPRITES = 4
+
+MAGIC = b'TIA1'
+HEADER = struct.Struct('<4sBBH')
+PAGE = struct.Struct('<IHBBBB16s')
+SPRITE = struct.Struct('<BBBBB')
+
+# GBitmapFormat
+FORMAT_1BIT = 0
+FORMAT_8BIT = 1
+FORMAT_1BIT_PALETTE = 2
+FORMAT_2BIT_PALETTE = 3
+FORMAT_4BIT_PALETTE = 4
+
+
+def read_png(path):
+    """Decode a non-interlaced PNG into rows of (r, g, b, a) tuples."""
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError('%s: not a PNG' % path)
+
+    pos = 8
+    idat = b''
+    palette = []
+    alpha = b''
+
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+
+        if kind == b'IHDR':
+            width, height, depth, color_type, _, _, interlace = struct.unpack('>IIBBBBB', body)
+        elif kind == b'PLTE':
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b'tRNS':
+            alpha = body
+        elif kind == b'IDAT':
+            idat += body
+
+    if interlace:
+        raise ValueError('%s: interlaced PNGs are not supported' % path)
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    bits = channels * depth
+    stride = (width * bits + 7) // 8
+    bpp = max(1, bits // 8)
+    raw = zlib.decompress(idat)
+    rows = []
+    prev = bytearray(stride)
+
+    for y in range(height):
+        offset = y * (stride + 1)
+        kind = raw[offset]
+        line = bytearray(raw[offset + 1:offset + 1 + stride])
+
+        for x in range(stride):
+            a = line[x - bpp] if x >= bpp else 0
+            b = prev[x]
+            c = prev[x - bpp] if x >= bpp else 0
+
+            if kind == 1:
+                line[x] = (line[x] + a) & 0xFF
+            elif kind == 2:
+                line[x] = (line[x] + b) & 0xFF
+            elif kind == 3:
+                line[x] = (line[x] + (a + b) // 2) & 0xFF
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                line[x] = (line[x] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xFF
+
+        prev = line
+        samples = []
+
+        if depth < 8:
+            for byte in line:
+                for shift in range(8 - depth, -1, -depth):
+                    samples.append((byte >> shift) & ((1 << depth) - 1))
+        elif depth == 8:
+            samples = list(line)
+        else:
+            samples = [line[i] << 8 | line[i + 1] for i in range(0, len(line), 2)]
+
+        scale = 255.0 / ((1 << depth) - 1)
+        row = []
+
+        for x in range(width):
+            s = samples[x * channels:(x + 1) * channels]
+
+            if color_type == 3:
+                rgb = palette[s[0]]
+                row.append(rgb + (alpha[s[0]] if s[0] < len(alpha) else 255,))
+            elif color_type == 0:
+                v = int(s[0] * scale)
+                row.append((v, v, v, 255))
+            elif color_type == 4:
+                v = int(s[0] * scale)
+                row.append((v, v, v, int(s[1] * scale)))
+            else:
+                v = [int(c * scale) for c in s]
+                row.append(tuple(v) if channels == 4 else tuple(v) + (255,))
+
+        rows.append(row)
+
+    return width, height, rows
+
+
+def gcolor8(rgba):
+    """The GColor8 a pixel is shown as: two bits each of alpha, red, green and blue."""
+    r, g, b, a = rgba
+
+    if a < 128:
+        return 0x00     # GColorClear
+
+    return 0xC0 | (r >> 6) << 4 | (g >> 6) << 2 | (b >> 6)
+
+
+def encode_page(sprites, color):
+    """Lay the sprites of one page side by side; (format, palette, rows, w, h)."""
+    w = sum(s[0] for s in sprites)
+    h = max(s[1] for s in sprites)
+    pixels = [[0x00] * w for _ in range(h)]
+    x = 0
+
+    for sw, sh, rows in sprites:
+        for y in range(sh):
+            for i in range(sw):
+                rgba = rows[y][i]
+
+                if color:
+                    pixels[y][x + i] = gcolor8(rgba)
+                else:
+                    # black and white: transparent or dark is black, the rest white
+                    pixels[y][x + i] = 1 if rgba[3] >= 128 and sum(rgba[:3]) >= 3 * 128 else 0
+        x += sw
+
+    if not color:
+        stride = (w + 31) // 32 * 4
+        data = bytearray()
+
+        for row in pixels:
+            line = bytearray(stride)
+            for i, bit in enumerate(row):
+                line[i // 8] |= bit << (i % 8)     # least significant bit is leftmost
+            data += line
+
+        return FORMAT_1BIT, b'', stride, w, h, bytes(data)
+
+    colors = sorted(set(c for row in pixels for c in row))
+
+    if len(colors) > 16:
+        return FORMAT_8BIT, b'', w, w, h, bytes(c for row in pixels for c in row)
+
+    depth, fmt = (1, FORMAT_1BIT_PALETTE) if len(colors) <= 2 else \
+                 (2, FORMAT_2BIT_PALETTE) if len(colors) <= 4 else (4, FORMAT_4BIT_PALETTE)
+    index = dict((c, i) for i, c in enumerate(colors))
+    stride = (w * depth + 7) // 8
+    data = bytearray()
+
+    for row in pixels:
+        line = bytearray(stride)
+        for i, c in enumerate(row):
+            # most significant bits are leftmost
+            line[i * depth // 8] |= index[c] << (8 - depth - i * depth % 8)
+        data += line
+
+    return fmt, bytes(colors), stride, w, h, bytes(data)
+
+
+def read_manifest(resource_dir):
+    with open(os.path.join(resource_dir, MANIFEST)) as f:
+        return json.load(f)
+
+
+def read_sprites(image_dir, color, manifest):
+    sprites = []
+
+    for name in [e['image'] for e in manifest['icons'] + manifest['glyphs']]:
+        path = os.path.join(image_dir, name + ('~color.png' if color else '.png'))
+
+        if color and not os.path.exists(path):
+            path = os.path.join(image_dir, name + '.png')
+
+        sprites.append(read_png(path))
+
+    return sprites
+
+
+def paginate(sprites):
+    """Consecutive sprites of one size share a page; lists of (index, sprite)."""
+    pages = []
+
+    for index, sprite in enumerate(sprites):
+        page = pages[-1] if pages else None
+
+        if not page or len(page) == PAGE_SPRITES or page[0][1][:2] != sprite[:2]:
+            page = []
+            pages.append(page)
+
+        page.append((index, sprite))
+
+    return pages
+
+
+def pack(image_dir, color, manifest):
+    """The atlas for black and white or color platforms, as bytes."""
+    sprites = read_sprites(image_dir, color, manifest)
+    pages = paginate(sprites)
+
+    table_size = HEADER.size + len(pages) * PAGE.size + len(sprites) * SPRITE.size
+    page_table = b''
+    sprite_table = [None] * len(sprites)
+    data = b''
+
+    for number, page in enumerate(pages):
+        fmt, palette, stride, w, h, pixels = encode_page([s for _, s in page], color)
+        page_table += PAGE.pack(table_size + len(data), stride, w, h, fmt, len(palette), palette)
+        data += pixels
+        x = 0
+
+        for index, (sw, sh, _) in page:
+            sprite_table[index] = SPRITE.pack(number, x, 0, sw, sh)
+            x += sw
+
+    return HEADER.pack(MAGIC, len(sprites), len(pages), 0) + page_table + b''.join(sprite_table) + data
+
+
+def table(image_dir, manifest):
+    """src/icon_table.auto.h: the icon count, the glyph sprite indices, the atlas page
+    count and the labels."""
+    icons, glyphs = manifest['icons'], manifest['glyphs']
+    pages = max(len(paginate(read_sprites(image_dir, color, manifest))) for color in (False, True))
+    lines = [
+        '// Generated by tools/icon_atlas.py from resources/%s, do not edit' % MANIFEST,
+        '#pragma once',
+        '',
+        '#define TIMER_ICON_ITEMS %d' % len(icons),
+        '#define ICON_ATLAS_PAGES %d        // Pages of the larger of the two atlases' % pages,
+        '',
+    ]
+
+    for index, glyph in enumerate(glyphs):
+        lines.append('#define SPRITE_%-17s(TIMER_ICON_ITEMS + %d)' % (glyph['sprite'], index))
+
+    lines += [
+        '#define SPRITE_COUNT            (TIMER_ICON_ITEMS + %d)' % len(glyphs),
+        '',
+        '// X(label) for each timer icon, in iconIdx order',
+        '#define TIMER_ICON_TABLE(X) \\',
+    ]
+    lines += ['    X(%s) \\' % json.dumps(icon['label']) for icon in icons]
+    lines.append('')
+    return '\n'.join(lines) + '\n'
+
+
+def write_if_stale(out, sources, make):
+    if os.path.exists(out) and os.path.getmtime(out) >= max(os.path.getmtime(f) for f in sources):
+        return
+
+    if not os.path.isdir(os.path.dirname(out)):
+        os.makedirs(os.path.dirname(out))
+
+    with open(out, 'wb') as f:
+        f.write(make())
+
+
+def build(resource_dir, src_dir):
+    """Write the black and white and color atlases and the icon table, if stale."""
+    image_dir = os.path.join(resource_dir, 'images')
+    manifest_path = os.path.join(resource_dir, MANIFEST)
+    manifest = read_manifest(resource_dir)
+    sources = [os.path.join(image_dir, f) for f in os.listdir(image_dir)] + [manifest_path, __file__]
+
+    for color, name in ((False, 'icon_atlas~bw.bin'), (True, 'icon_atlas~color.bin')):
+        write_if_stale(os.path.join(resource_dir, 'data', name), sources,
+                       lambda: pack(image_dir, color, manifest))
+
+    write_if_stale(os.path.join(src_dir, 'icon_table.auto.h'), sources,
+                   lambda: table(image_dir, manifest).encode('ascii'))
+
+
+if __name__ == '__main__':
+    import sys
+
+    args = sys.argv[1:]
+
+    if len(args) == 3 and args[0] in ('--bw', '--color'):
+        # icon_atlas.py --bw|--color <resource dir> <out>
+        resource_dir = args[1]
+        data = pack(os.path.join(resource_dir, 'images'), args[0] == '--color', read_manifest(resource_dir))
+    elif len(args) == 3 and args[0] == '--table':
+        # icon_atlas.py --table <resource dir> <out>
+        data = table(os.path.join(args[1], 'images'), read_manifest(args[1])).encode('ascii')
+    else:
+        sys.stderr.write('usage: icon_atlas.py --bw|--color|--table <resource dir> <out>\n')
+        sys.exit(2)
+
+    with open(args[2], 'wb') as f:
+        f.write(data)